@@ -18,11 +18,17 @@ CREATE TABLE IF NOT EXISTS charts (
     zoom       INTEGER                  NOT NULL,
     covr       GEOMETRY(GEOMETRY, 4326) NOT NULL,
     dsid_props JSONB                    NOT NULL,
-    chart_txt  JSONB                    NOT NULL
+    chart_txt  JSONB                    NOT NULL,
+    min_x      REAL                     NULL,
+    min_y      REAL                     NULL,
+    max_x      REAL                     NULL,
+    max_y      REAL                     NULL,
+    hkey       BIGINT                   NULL
 );
 
 CREATE INDEX IF NOT EXISTS charts_gist ON charts USING GIST (covr);
 CREATE INDEX IF NOT EXISTS charts_idx ON charts (id);
+CREATE INDEX IF NOT EXISTS charts_hkey_idx ON charts (hkey);
 
 CREATE TABLE IF NOT EXISTS features (
     id        BIGSERIAL PRIMARY KEY,
@@ -31,11 +37,161 @@ CREATE TABLE IF NOT EXISTS features (
     props     JSONB                         NOT NULL,
     chart_id  BIGINT REFERENCES charts (id) NOT NULL,
     lnam_refs VARCHAR[]                     NULL,
-    z_range   INT4RANGE                     NOT NULL
+    z_range   INT4RANGE                     NOT NULL,
+    min_x     REAL                          NULL,
+    min_y     REAL                          NULL,
+    max_x     REAL                          NULL,
+    max_y     REAL                          NULL,
+    hkey      BIGINT                        NULL
 );
 
+-- Envelope (rounded outwards) and Hilbert key of the envelope center,
+-- added after version 1
+ALTER TABLE charts ADD COLUMN IF NOT EXISTS min_x REAL NULL,
+                   ADD COLUMN IF NOT EXISTS min_y REAL NULL,
+                   ADD COLUMN IF NOT EXISTS max_x REAL NULL,
+                   ADD COLUMN IF NOT EXISTS max_y REAL NULL,
+                   ADD COLUMN IF NOT EXISTS hkey BIGINT NULL;
+ALTER TABLE features ADD COLUMN IF NOT EXISTS min_x REAL NULL,
+                     ADD COLUMN IF NOT EXISTS min_y REAL NULL,
+                     ADD COLUMN IF NOT EXISTS max_x REAL NULL,
+                     ADD COLUMN IF NOT EXISTS max_y REAL NULL,
+                     ADD COLUMN IF NOT EXISTS hkey BIGINT NULL;
+
 CREATE INDEX IF NOT EXISTS features_gist ON features USING GIST (geom);
 CREATE INDEX IF NOT EXISTS features_idx ON features (id);
 CREATE INDEX IF NOT EXISTS features_layer_idx ON features (layer);
 CREATE INDEX IF NOT EXISTS features_zoom_idx ON features USING GIST (z_range);
+CREATE INDEX IF NOT EXISTS features_hkey_idx ON features (hkey);
 CREATE INDEX IF NOT EXISTS features_lnam_idx ON features USING GIN (lnam_refs);
+
+-- Simplified geometry per zoom band, written with --generalize
+-- A band's row replaces features.geom for zooms inside its z_range
+CREATE TABLE IF NOT EXISTS feature_lods (
+    feature_id BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    z_range    INT4RANGE                                         NOT NULL,
+    geom       GEOMETRY(GEOMETRY, 4326)                          NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS feature_lods_gist ON feature_lods USING GIST (geom);
+CREATE INDEX IF NOT EXISTS feature_lods_feature_idx ON feature_lods (feature_id);
+CREATE INDEX IF NOT EXISTS feature_lods_zoom_idx ON feature_lods USING GIST (z_range);
+
+-- Pieces of large areas, written with --subdivide
+-- Spatial lookups hit the small pieces, then join back to the feature
+CREATE TABLE IF NOT EXISTS feature_parts (
+    feature_id BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    part       INTEGER                                           NOT NULL,
+    geom       GEOMETRY(GEOMETRY, 4326)                          NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS feature_parts_gist ON feature_parts USING GIST (geom);
+CREATE INDEX IF NOT EXISTS feature_parts_feature_idx ON feature_parts (feature_id);
+
+-- SOUNDG stored compactly, written with --compact-soundings
+-- Soundings of one source feature share a sounding_attrs row
+CREATE TABLE IF NOT EXISTS sounding_attrs (
+    id       BIGSERIAL PRIMARY KEY,
+    chart_id BIGINT REFERENCES charts (id) ON DELETE CASCADE NOT NULL,
+    props    JSONB                                        NOT NULL,
+    z_range  INT4RANGE                                    NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS soundings (
+    chart_id BIGINT REFERENCES charts (id) ON DELETE CASCADE         NOT NULL,
+    attrs_id BIGINT REFERENCES sounding_attrs (id) ON DELETE CASCADE NOT NULL,
+    geom     GEOMETRY(POINT, 4326)                                   NOT NULL,
+    depth    REAL                    -- NULL if the source point had no Z
+);
+
+CREATE INDEX IF NOT EXISTS sounding_attrs_chart_idx ON sounding_attrs (chart_id);
+CREATE INDEX IF NOT EXISTS soundings_gist ON soundings USING GIST (geom);
+CREATE INDEX IF NOT EXISTS soundings_chart_idx ON soundings (chart_id);
+CREATE INDEX IF NOT EXISTS soundings_attrs_idx ON soundings (attrs_id);
+
+-- LNAM references resolved within each chart
+-- kind is what to_id is to from_id: master, slave or peer (from FFPT_RIND),
+-- or aggregate/association for C_AGGR/C_ASSO members
+CREATE TABLE IF NOT EXISTS feature_links (
+    from_id BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    to_id   BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    kind    VARCHAR                                           NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS feature_links_from_idx ON feature_links (from_id);
+CREATE INDEX IF NOT EXISTS feature_links_to_idx ON feature_links (to_id);
+
+-- Chart quilt: the part of each chart's coverage it owns per zoom band,
+-- where better-scale charts take precedence (ties go to the newer chart)
+CREATE TABLE IF NOT EXISTS chart_quilt (
+    chart_id BIGINT REFERENCES charts (id) ON DELETE CASCADE NOT NULL,
+    z_range  INT4RANGE                                    NOT NULL,
+    geom     GEOMETRY(GEOMETRY, 4326)                     NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS chart_quilt_gist ON chart_quilt USING GIST (geom);
+CREATE INDEX IF NOT EXISTS chart_quilt_chart_idx ON chart_quilt (chart_id);
+CREATE INDEX IF NOT EXISTS chart_quilt_zoom_idx ON chart_quilt USING GIST (z_range);
+
+-- Coverage that changed since the quilt was last updated. Only recorded
+-- once a quilt has been built (meta key 'quilt'); until then the next
+-- update computes the whole quilt anyway
+CREATE TABLE IF NOT EXISTS chart_quilt_dirty (
+    covr GEOMETRY(GEOMETRY, 4326) NOT NULL
+);
+
+CREATE OR REPLACE FUNCTION chart_quilt_mark_dirty() RETURNS trigger AS $$
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM meta WHERE key = 'quilt') THEN
+        RETURN NULL;
+    END IF;
+    IF TG_OP <> 'INSERT' THEN
+        INSERT INTO chart_quilt_dirty (covr) VALUES (OLD.covr);
+    END IF;
+    IF TG_OP <> 'DELETE' THEN
+        INSERT INTO chart_quilt_dirty (covr) VALUES (NEW.covr);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS charts_quilt_dirty ON charts;
+CREATE TRIGGER charts_quilt_dirty
+    AFTER INSERT OR DELETE OR UPDATE OF covr, scale, zoom ON charts
+    FOR EACH ROW EXECUTE FUNCTION chart_quilt_mark_dirty();
+
+-- One row per shard of a sharded ingest (--shard i/N), written when the
+-- shard finishes and merged by --shard-summary
+CREATE TABLE IF NOT EXISTS ingest_shards (
+    run_id      VARCHAR     NOT NULL,
+    shard       INTEGER     NOT NULL,
+    shard_count INTEGER     NOT NULL,
+    host        VARCHAR     NOT NULL,
+    files       INTEGER     NOT NULL,
+    succeeded   INTEGER     NOT NULL,
+    failed      INTEGER     NOT NULL,
+    skipped     INTEGER     NOT NULL,
+    features    BIGINT      NOT NULL,
+    failures    JSONB       NOT NULL,
+    finished_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    PRIMARY KEY (run_id, shard)
+);
+
+-- Shared work queue for cooperative ingest (--queue). Processes claim
+-- cells with FOR UPDATE SKIP LOCKED and keep their claims alive with
+-- heartbeats; claims whose heartbeat stops are taken back
+CREATE TABLE IF NOT EXISTS ingest_queue (
+    id          BIGSERIAL   PRIMARY KEY,
+    queue       VARCHAR     NOT NULL,
+    path        VARCHAR     NOT NULL,
+    size        BIGINT      NOT NULL DEFAULT 0,
+    status      VARCHAR     NOT NULL DEFAULT 'pending',
+    attempts    INTEGER     NOT NULL DEFAULT 0,
+    worker      VARCHAR     NULL,
+    heartbeat   TIMESTAMPTZ NULL,
+    features    INTEGER     NULL,
+    error       TEXT        NULL,
+    UNIQUE (queue, path)
+);
+CREATE INDEX IF NOT EXISTS ingest_queue_open_idx ON ingest_queue (queue, size DESC)
+    WHERE status IN ('pending', 'running');
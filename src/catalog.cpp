@@ -0,0 +1,289 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// In-memory chart catalog implementation
+
+#include "catalog.hpp"
+#include "database.hpp"
+#include "s57.hpp"
+#include "geometry.hpp"
+
+#include <ogr_geometry.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <thread>
+#include <functional>
+
+namespace s57 {
+
+namespace {
+    // Children per R-tree node
+    constexpr size_t NODE_CAPACITY = 16;
+
+    bool intersects(const BoundingBox& a, const BoundingBox& b) {
+        return a.valid && b.valid &&
+               a.minX <= b.maxX && b.minX <= a.maxX &&
+               a.minY <= b.maxY && b.minY <= a.maxY;
+    }
+
+    // Sort-Tile-Recursive order: vertical slices by center x, each sorted
+    // by center y, so consecutive runs of NODE_CAPACITY are compact
+    void strSort(std::vector<uint32_t>& ids, const std::function<const BoundingBox&(uint32_t)>& boxOf) {
+        auto centerX = [&](uint32_t i) { return boxOf(i).minX + boxOf(i).maxX; };
+        auto centerY = [&](uint32_t i) { return boxOf(i).minY + boxOf(i).maxY; };
+
+        std::sort(ids.begin(), ids.end(), [&](uint32_t a, uint32_t b) { return centerX(a) < centerX(b); });
+
+        size_t nodeCount = (ids.size() + NODE_CAPACITY - 1) / NODE_CAPACITY;
+        size_t slices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+        size_t sliceSize = std::max<size_t>(1, slices) * NODE_CAPACITY;
+        for (size_t start = 0; start < ids.size(); start += sliceSize) {
+            auto end = ids.begin() + static_cast<long>(std::min(start + sliceSize, ids.size()));
+            std::sort(ids.begin() + static_cast<long>(start), end,
+                      [&](uint32_t a, uint32_t b) { return centerY(a) < centerY(b); });
+        }
+    }
+}
+
+void ChartCatalog::GeometryDeleter::operator()(OGRGeometry* geometry) const {
+    OGRGeometryFactory::destroyGeometry(geometry);
+}
+
+ChartCatalog::ChartCatalog() = default;
+ChartCatalog::~ChartCatalog() = default;
+ChartCatalog::ChartCatalog(ChartCatalog&&) noexcept = default;
+ChartCatalog& ChartCatalog::operator=(ChartCatalog&&) noexcept = default;
+
+bool ChartCatalog::loadFromDatabase(Database& database, bool withCoverage) {
+    if (!database.isConnected()) return false;
+
+    for (const auto& [id, info] : database.getCharts(withCoverage)) {
+        add(info, id);
+    }
+    build();
+    return true;
+}
+
+size_t ChartCatalog::loadFromFiles(const std::vector<std::string>& files, int workers) {
+    std::vector<std::optional<ChartInfo>> infos(files.size());
+    std::atomic<size_t> nextFile{0};
+
+    auto worker = [&]() {
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+            S57 chart(files[i]);
+            if (chart.isOpen()) {
+                infos[i] = chart.getChartInfo();
+            }
+        }
+    };
+
+    size_t threadCount = std::min(files.size(), static_cast<size_t>(std::max(1, workers)));
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    size_t added = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (infos[i]) {
+            add(*infos[i], 0, files[i]);
+            ++added;
+        }
+    }
+    build();
+    return added;
+}
+
+void ChartCatalog::add(const ChartInfo& info, int64_t id, const std::string& filePath) {
+    std::unique_ptr<OGRGeometry, GeometryDeleter> coverage;
+    if (!info.covrGeoJson.empty() && info.covrGeoJson != "{}") {
+        coverage.reset(OGRGeometryFactory::createFromGeoJson(info.covrGeoJson.c_str()));
+    }
+
+    CatalogEntry entry;
+    entry.id = id;
+    entry.filePath = filePath;
+    entry.info = info;
+    // Coverage is kept parsed; the GeoJSON copy isn't needed any more
+    entry.info.covrGeoJson.clear();
+
+    auto it = byName_.find(info.name);
+    if (it != byName_.end()) {
+        entries_[it->second] = std::move(entry);
+        coverages_[it->second] = std::move(coverage);
+    } else {
+        byName_.emplace(info.name, entries_.size());
+        entries_.push_back(std::move(entry));
+        coverages_.push_back(std::move(coverage));
+    }
+    built_ = false;
+}
+
+void ChartCatalog::build() {
+    levels_.clear();
+    items_.clear();
+    built_ = true;
+
+    for (uint32_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].info.bbox.valid) {
+            items_.push_back(i);
+        }
+    }
+    if (items_.empty()) return;
+
+    strSort(items_, [this](uint32_t i) -> const BoundingBox& { return entries_[i].info.bbox; });
+
+    std::vector<Node> leaves;
+    for (size_t start = 0; start < items_.size(); start += NODE_CAPACITY) {
+        Node node;
+        node.first = static_cast<uint32_t>(start);
+        node.count = static_cast<uint32_t>(std::min(NODE_CAPACITY, items_.size() - start));
+        for (uint32_t k = 0; k < node.count; ++k) {
+            geometry::expand(node.bbox, entries_[items_[start + k]].info.bbox);
+        }
+        leaves.push_back(node);
+    }
+    levels_.push_back(std::move(leaves));
+
+    // Each level is put in STR order right before its parents are packed,
+    // so parents can refer to a contiguous run of children
+    while (levels_.back().size() > 1) {
+        std::vector<Node>& children = levels_.back();
+        std::vector<uint32_t> order(children.size());
+        std::iota(order.begin(), order.end(), 0);
+        strSort(order, [&children](uint32_t i) -> const BoundingBox& { return children[i].bbox; });
+
+        std::vector<Node> sorted;
+        sorted.reserve(children.size());
+        for (uint32_t i : order) {
+            sorted.push_back(children[i]);
+        }
+        children = std::move(sorted);
+
+        std::vector<Node> parents;
+        for (size_t start = 0; start < children.size(); start += NODE_CAPACITY) {
+            Node node;
+            node.first = static_cast<uint32_t>(start);
+            node.count = static_cast<uint32_t>(std::min(NODE_CAPACITY, children.size() - start));
+            for (uint32_t k = 0; k < node.count; ++k) {
+                geometry::expand(node.bbox, children[start + k].bbox);
+            }
+            parents.push_back(node);
+        }
+        levels_.push_back(std::move(parents));
+    }
+}
+
+void ChartCatalog::clear() {
+    entries_.clear();
+    coverages_.clear();
+    byName_.clear();
+    levels_.clear();
+    items_.clear();
+    built_ = true;
+}
+
+size_t ChartCatalog::size() const {
+    return entries_.size();
+}
+
+const std::vector<CatalogEntry>& ChartCatalog::entries() const {
+    return entries_;
+}
+
+const CatalogEntry* ChartCatalog::find(const std::string& name) const {
+    auto it = byName_.find(name);
+    return it != byName_.end() ? &entries_[it->second] : nullptr;
+}
+
+bool ChartCatalog::contains(const std::string& name) const {
+    return byName_.count(name) > 0;
+}
+
+std::vector<size_t> ChartCatalog::search(const BoundingBox& bbox) const {
+    std::vector<size_t> found;
+
+    // After add() without build() the tree is stale; scan instead
+    if (!built_) {
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            if (intersects(entries_[i].info.bbox, bbox)) found.push_back(i);
+        }
+        return found;
+    }
+    if (levels_.empty()) return found;
+
+    // Depth-first over (level, node) pairs from the root
+    std::vector<std::pair<size_t, uint32_t>> stack = {{levels_.size() - 1, 0}};
+    while (!stack.empty()) {
+        auto [level, index] = stack.back();
+        stack.pop_back();
+
+        const Node& node = levels_[level][index];
+        if (!intersects(node.bbox, bbox)) continue;
+
+        for (uint32_t k = node.first; k < node.first + node.count; ++k) {
+            if (level == 0) {
+                uint32_t entry = items_[k];
+                if (intersects(entries_[entry].info.bbox, bbox)) found.push_back(entry);
+            } else {
+                stack.emplace_back(level - 1, k);
+            }
+        }
+    }
+    return found;
+}
+
+std::vector<const CatalogEntry*> ChartCatalog::query(const BoundingBox& bbox) const {
+    std::vector<const CatalogEntry*> result;
+    for (size_t i : search(bbox)) {
+        result.push_back(&entries_[i]);
+    }
+    return result;
+}
+
+std::vector<const CatalogEntry*> ChartCatalog::covering(double lon, double lat) const {
+    BoundingBox point;
+    point.minX = point.maxX = lon;
+    point.minY = point.maxY = lat;
+    point.valid = true;
+
+    OGRPoint probe(lon, lat);
+    std::vector<const CatalogEntry*> result;
+    for (size_t i : search(point)) {
+        if (coverages_[i] && !coverages_[i]->Intersects(&probe)) continue;
+        result.push_back(&entries_[i]);
+    }
+    sortByScale(result);
+    return result;
+}
+
+std::vector<const CatalogEntry*> ChartCatalog::overlapping(const std::string& name) const {
+    std::vector<const CatalogEntry*> result;
+    auto it = byName_.find(name);
+    if (it == byName_.end()) return result;
+
+    const OGRGeometry* coverage = coverages_[it->second].get();
+    for (size_t i : search(entries_[it->second].info.bbox)) {
+        if (i == it->second) continue;
+        if (coverage && coverages_[i] && !coverages_[i]->Intersects(coverage)) continue;
+        result.push_back(&entries_[i]);
+    }
+    sortByScale(result);
+    return result;
+}
+
+void ChartCatalog::sortByScale(std::vector<const CatalogEntry*>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const CatalogEntry* a, const CatalogEntry* b) {
+        if (a->info.scale != b->info.scale) return a->info.scale < b->info.scale;
+        return a->info.name < b->info.name;
+    });
+}
+
+} // namespace s57
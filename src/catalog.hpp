@@ -0,0 +1,115 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// In-memory chart catalog header
+
+#ifndef S57_POSTGIS_CATALOG_HPP
+#define S57_POSTGIS_CATALOG_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+// Forward declarations for GDAL types
+class OGRGeometry;
+
+namespace s57 {
+
+class Database;
+
+// A chart known to the catalog
+struct CatalogEntry {
+    int64_t id = 0;             // charts.id (0 when scanned from files)
+    std::string filePath;       // Source file (empty when loaded from the database)
+    ChartInfo info;
+};
+
+// ChartCatalog keeps chart metadata and coverage in memory so coverage and
+// overlap questions don't need a database round trip. Entries come from the
+// charts table or from S57::getChartInfo scans; an STR-packed R-tree over
+// their bounding boxes narrows queries before the exact coverage test.
+//
+// Loading and add() are not synchronized. Once loaded (or after build()),
+// the catalog can be queried from any number of threads.
+class ChartCatalog {
+public:
+    ChartCatalog();
+    ~ChartCatalog();
+
+    // Allow moving, prevent copying
+    ChartCatalog(ChartCatalog&&) noexcept;
+    ChartCatalog& operator=(ChartCatalog&&) noexcept;
+    ChartCatalog(const ChartCatalog&) = delete;
+    ChartCatalog& operator=(const ChartCatalog&) = delete;
+
+    // Load all charts from the database (coverage geometry is optional;
+    // without it queries stop at the bounding box)
+    bool loadFromDatabase(Database& database, bool withCoverage = true);
+
+    // Scan S-57 files with getChartInfo on several threads
+    // Returns the number of charts added
+    size_t loadFromFiles(const std::vector<std::string>& files, int workers = 1);
+
+    // Add a chart, replacing any entry with the same name
+    void add(const ChartInfo& info, int64_t id = 0, const std::string& filePath = "");
+
+    // Rebuild the R-tree after add() (loaders do this themselves)
+    void build();
+
+    // Remove all entries
+    void clear();
+
+    // Number of charts
+    size_t size() const;
+
+    // All entries, in insertion order
+    const std::vector<CatalogEntry>& entries() const;
+
+    // Look up a chart by name (nullptr if unknown)
+    const CatalogEntry* find(const std::string& name) const;
+
+    // Check if a chart is known by name
+    bool contains(const std::string& name) const;
+
+    // Charts whose bounding box intersects bbox
+    std::vector<const CatalogEntry*> query(const BoundingBox& bbox) const;
+
+    // Charts whose coverage contains a point, best scale first
+    std::vector<const CatalogEntry*> covering(double lon, double lat) const;
+
+    // Charts whose coverage overlaps the named chart's, best scale first
+    std::vector<const CatalogEntry*> overlapping(const std::string& name) const;
+
+private:
+    struct GeometryDeleter {
+        void operator()(OGRGeometry* geometry) const;
+    };
+
+    struct Node {
+        BoundingBox bbox;
+        uint32_t first = 0;     // First child in the level below (or in items_)
+        uint32_t count = 0;
+    };
+
+    std::vector<CatalogEntry> entries_;
+    std::vector<std::unique_ptr<OGRGeometry, GeometryDeleter>> coverages_;  // Parallel to entries_
+    std::unordered_map<std::string, size_t> byName_;
+
+    // R-tree levels from the leaves (levels_[0]) up to the root
+    std::vector<std::vector<Node>> levels_;
+    std::vector<uint32_t> items_;   // Entry indices in leaf order
+    bool built_ = true;
+
+    // Entry indices whose bounding box intersects bbox
+    std::vector<size_t> search(const BoundingBox& bbox) const;
+
+    // Sort entries by scale (best first), then by name
+    static void sortByScale(std::vector<const CatalogEntry*>& entries);
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_CATALOG_HPP
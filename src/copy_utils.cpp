@@ -0,0 +1,149 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// PostgreSQL COPY text format utilities implementation
+
+#include "copy_utils.hpp"
+#include "geometry.hpp"
+
+#include <cstdio>
+#include <cmath>
+
+namespace s57 {
+namespace pgcopy {
+
+std::string escape(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '\t': escaped += "\\t"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            default:   escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string arrayLiteral(const std::vector<std::string>& items) {
+    if (items.empty()) {
+        return NULL_VALUE;
+    }
+
+    std::string literal = "{";
+    bool first = true;
+    for (const auto& item : items) {
+        if (!first) literal += ",";
+        first = false;
+        literal += "\"";
+        for (char c : item) {
+            if (c == '"' || c == '\\') literal += '\\';
+            literal += c;
+        }
+        literal += "\"";
+    }
+    literal += "}";
+    return escape(literal);
+}
+
+std::string bboxColumns(const BoundingBox& bbox, int64_t hkey) {
+    std::string columns;
+    if (!bbox.valid) {
+        for (int i = 0; i < 5; ++i) {
+            columns += '\t';
+            columns += NULL_VALUE;
+        }
+        return columns;
+    }
+    columns += '\t'; columns += number(geometry::floatBelow(bbox.minX));
+    columns += '\t'; columns += number(geometry::floatBelow(bbox.minY));
+    columns += '\t'; columns += number(geometry::floatAbove(bbox.maxX));
+    columns += '\t'; columns += number(geometry::floatAbove(bbox.maxY));
+    columns += '\t'; columns += std::to_string(hkey);
+    return columns;
+}
+
+std::string chartRow(int64_t stageId, const ChartInfo& chart) {
+    std::string row;
+    row += std::to_string(stageId);
+    row += '\t'; row += escape(chart.name);
+    row += '\t'; row += std::to_string(chart.scale);
+    row += '\t'; row += escape(chart.fileName);
+    row += '\t'; row += escape(chart.updated);
+    row += '\t'; row += escape(chart.issued);
+    row += '\t'; row += std::to_string(chart.zoom);
+    row += '\t'; row += escape(chart.covrGeoJson);
+    row += '\t'; row += escape(chart.dsidProps);
+    row += '\t'; row += escape(chart.chartTxt);
+    row += bboxColumns(chart.bbox, chart.hkey);
+    return row;
+}
+
+std::string featureRow(int64_t stageId, int64_t chartStageId, const Feature& feature) {
+    std::string row;
+    row += std::to_string(stageId);
+    row += '\t'; row += std::to_string(chartStageId);
+    row += '\t'; row += escape(feature.layer);
+    row += '\t'; row += escape(feature.geomGeoJson);
+    row += '\t'; row += escape(feature.propsJson);
+    row += '\t'; row += arrayLiteral(feature.lnamRefs);
+    row += '\t'; row += std::to_string(feature.minZ);
+    row += '\t'; row += std::to_string(feature.maxZ);
+    row += bboxColumns(feature.bbox, feature.hkey);
+    return row;
+}
+
+std::string lodRow(int64_t featureStageId, const GeometryLod& lod) {
+    std::string row;
+    row += std::to_string(featureStageId);
+    row += '\t'; row += std::to_string(lod.minZ);
+    row += '\t'; row += std::to_string(lod.maxZ);
+    row += '\t'; row += escape(lod.geomGeoJson);
+    return row;
+}
+
+std::string partRow(int64_t featureStageId, int part, const std::string& geomGeoJson) {
+    std::string row;
+    row += std::to_string(featureStageId);
+    row += '\t'; row += std::to_string(part);
+    row += '\t'; row += escape(geomGeoJson);
+    return row;
+}
+
+std::string linkRow(int64_t fromId, int64_t toId, const std::string& kind) {
+    std::string row;
+    row += std::to_string(fromId);
+    row += '\t'; row += std::to_string(toId);
+    row += '\t'; row += escape(kind);
+    return row;
+}
+
+std::string soundingAttrsRow(int64_t stageId, int64_t chartStageId, const SoundingAttrs& attrs) {
+    std::string row;
+    row += std::to_string(stageId);
+    row += '\t'; row += std::to_string(chartStageId);
+    row += '\t'; row += escape(attrs.propsJson);
+    row += '\t'; row += std::to_string(attrs.minZ);
+    row += '\t'; row += std::to_string(attrs.maxZ);
+    return row;
+}
+
+std::string soundingRow(int64_t attrsStageId, const Sounding& sounding) {
+    std::string row;
+    row += std::to_string(attrsStageId);
+    row += '\t'; row += number(sounding.lon);
+    row += '\t'; row += number(sounding.lat);
+    row += '\t'; row += std::isnan(sounding.depth) ? NULL_VALUE : number(sounding.depth);
+    return row;
+}
+
+std::string number(double value) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return std::string(buffer, length > 0 ? static_cast<size_t>(length) : 0);
+}
+
+} // namespace pgcopy
+} // namespace s57
@@ -0,0 +1,91 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// PostgreSQL COPY text format utilities
+
+#ifndef S57_POSTGIS_COPY_UTILS_HPP
+#define S57_POSTGIS_COPY_UTILS_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace s57 {
+namespace pgcopy {
+
+// NULL marker in COPY text format
+inline const char* NULL_VALUE = "\\N";
+
+// Column order of the staging tables, matching the row builders below
+inline const std::vector<std::string> CHART_COLUMNS = {
+    "stage_id", "name", "scale", "file_name", "updated", "issued",
+    "zoom", "covr", "dsid_props", "chart_txt",
+    "min_x", "min_y", "max_x", "max_y", "hkey"
+};
+
+inline const std::vector<std::string> FEATURE_COLUMNS = {
+    "stage_id", "chart_stage_id", "layer", "geom", "props", "lnam_refs", "min_z", "max_z",
+    "min_x", "min_y", "max_x", "max_y", "hkey"
+};
+
+inline const std::vector<std::string> LOD_COLUMNS = {
+    "feature_stage_id", "min_z", "max_z", "geom"
+};
+
+inline const std::vector<std::string> PART_COLUMNS = {
+    "feature_stage_id", "part", "geom"
+};
+
+inline const std::vector<std::string> LINK_COLUMNS = {
+    "from_stage_id", "to_stage_id", "kind"
+};
+
+inline const std::vector<std::string> SOUNDING_ATTRS_COLUMNS = {
+    "stage_id", "chart_stage_id", "props", "min_z", "max_z"
+};
+
+inline const std::vector<std::string> SOUNDING_COLUMNS = {
+    "attrs_stage_id", "lon", "lat", "depth"
+};
+
+// Escape a value for a COPY text format column
+std::string escape(const std::string& value);
+
+// Build a PostgreSQL array literal ({"a","b"}), or NULL_VALUE when empty
+// The result is already escaped for COPY
+std::string arrayLiteral(const std::vector<std::string>& items);
+
+// Tab-prefixed bbox and Hilbert key columns (min_x .. hkey), rounded
+// outwards to REAL; NULLs for an invalid bbox
+std::string bboxColumns(const BoundingBox& bbox, int64_t hkey);
+
+// Row for a staging_charts table (see Database::stagingTablesSql)
+std::string chartRow(int64_t stageId, const ChartInfo& chart);
+
+// Row for a staging_features table (see Database::stagingTablesSql)
+std::string featureRow(int64_t stageId, int64_t chartStageId, const Feature& feature);
+
+// Row for a staging_lods table (see Database::stagingTablesSql)
+std::string lodRow(int64_t featureStageId, const GeometryLod& lod);
+
+// Row for a staging_parts table (see Database::stagingTablesSql)
+std::string partRow(int64_t featureStageId, int part, const std::string& geomGeoJson);
+
+// Row for a staging_links table (see Database::stagingTablesSql), or for
+// feature_links itself when given feature ids
+std::string linkRow(int64_t fromId, int64_t toId, const std::string& kind);
+
+// Row for a staging_sounding_attrs table (see Database::stagingTablesSql)
+std::string soundingAttrsRow(int64_t stageId, int64_t chartStageId, const SoundingAttrs& attrs);
+
+// Row for a staging_soundings table (see Database::stagingTablesSql)
+std::string soundingRow(int64_t attrsStageId, const Sounding& sounding);
+
+// Format a double without losing precision
+std::string number(double value);
+
+} // namespace pgcopy
+} // namespace s57
+
+#endif // S57_POSTGIS_COPY_UTILS_HPP
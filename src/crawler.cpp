@@ -0,0 +1,170 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Parallel directory crawler implementation
+
+#include "crawler.hpp"
+#include "exchange_set.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+void CellQueue::push(CellFile cell) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_ || queued_.count(cell.path)) return;
+        if (active_.count(cell.path)) {
+            deferred_[cell.path] = std::move(cell);
+            return;
+        }
+        queued_.insert(cell.path);
+        cells_.push_back(std::move(cell));
+        ++pushed_;
+    }
+    ready_.notify_one();
+}
+
+void CellQueue::done(const CellFile& cell) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_.erase(cell.path);
+        auto it = deferred_.find(cell.path);
+        if (it == deferred_.end()) return;
+        CellFile again = std::move(it->second);
+        deferred_.erase(it);
+        if (closed_) return;
+        queued_.insert(again.path);
+        cells_.push_back(std::move(again));
+        ++pushed_;
+    }
+    ready_.notify_one();
+}
+
+void CellQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    ready_.notify_all();
+}
+
+std::optional<CellFile> CellQueue::pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return !cells_.empty() || closed_; });
+    if (cells_.empty()) return std::nullopt;
+
+    CellFile cell = std::move(cells_.front());
+    cells_.pop_front();
+    queued_.erase(cell.path);
+    active_.insert(cell.path);
+    return cell;
+}
+
+size_t CellQueue::pushed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pushed_;
+}
+
+DirectoryCrawler::DirectoryCrawler(std::string root, bool recursive, int threads)
+    : root_(std::move(root))
+    , recursive_(recursive)
+    , threadCount_(std::max(1, threads)) {
+}
+
+DirectoryCrawler::~DirectoryCrawler() {
+    join();
+}
+
+void DirectoryCrawler::start(CellQueue& queue) {
+    queue_ = &queue;
+    pending_.push_back(root_);
+    running_ = threadCount_;
+    for (int t = 0; t < threadCount_; ++t) {
+        threads_.emplace_back(&DirectoryCrawler::crawl, this);
+    }
+}
+
+void DirectoryCrawler::join() {
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+void DirectoryCrawler::crawl() {
+    for (;;) {
+        std::string dir;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pendingReady_.wait(lock, [this] { return !pending_.empty() || listing_ == 0; });
+            if (pending_.empty()) break;  // Nothing pending and nobody can add more
+
+            // Depth first keeps the pending stack small on wide trees
+            dir = std::move(pending_.back());
+            pending_.pop_back();
+            ++listing_;
+        }
+
+        listDirectory(dir);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --listing_;
+        }
+        pendingReady_.notify_all();
+    }
+
+    // The last thread out closes the queue
+    if (--running_ == 0) {
+        queue_->close();
+    }
+}
+
+void DirectoryCrawler::listDirectory(const std::string& dir) {
+    std::vector<std::pair<std::string, uintmax_t>> files;
+    std::vector<std::string> subdirs;
+
+    std::error_code ec;
+    fs::directory_iterator it(dir, ec);
+    for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        const fs::directory_entry& entry = *it;
+        std::error_code entryEc;
+
+        // Symlinked directories aren't followed, like recursive_directory_iterator
+        if (entry.is_directory(entryEc) && !entry.is_symlink(entryEc)) {
+            if (recursive_) subdirs.push_back(entry.path().string());
+            continue;
+        }
+
+        std::string ext = entry.path().extension().string();
+        if (ext.size() != 4 || !std::all_of(ext.begin() + 1, ext.end(),
+                                            [](unsigned char c) { return std::isdigit(c); })) {
+            continue;
+        }
+        if (!entry.is_regular_file(entryEc)) continue;
+
+        uintmax_t size = entry.file_size(entryEc);
+        files.emplace_back(entry.path().string(), entryEc ? 0 : size);
+    }
+
+    if (!subdirs.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.insert(pending_.end(), subdirs.begin(), subdirs.end());
+        }
+        pendingReady_.notify_all();
+    }
+
+    for (auto& cell : groupCellFiles(files, false)) {
+        queue_->push(std::move(cell));
+    }
+}
+
+} // namespace s57
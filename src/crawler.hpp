@@ -0,0 +1,104 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Parallel directory crawler header
+
+#ifndef S57_POSTGIS_CRAWLER_HPP
+#define S57_POSTGIS_CRAWLER_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+namespace s57 {
+
+// Unbounded queue of cells between discovery and the ingest workers.
+// A cell is queued at most once: pushing a cell that is already waiting is
+// a no-op, and pushing one a worker is still ingesting holds it back until
+// that worker calls done(), so the same cell is never ingested twice at
+// once and a change made during an ingest is not lost.
+class CellQueue {
+public:
+    // Add a cell (ignored once closed)
+    void push(CellFile cell);
+
+    // A worker finished the cell it popped; queues it again if it was
+    // pushed meanwhile
+    void done(const CellFile& cell);
+
+    // No more cells will be pushed; pop() drains what is left, then stops.
+    // Cells held back for a running ingest are dropped
+    void close();
+
+    // Next cell, waiting for one; nullopt once closed and empty
+    std::optional<CellFile> pop();
+
+    // Number of cells pushed so far
+    size_t pushed() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<CellFile> cells_;
+    std::unordered_set<std::string> queued_;               // Paths in cells_
+    std::unordered_set<std::string> active_;               // Popped, not done
+    std::unordered_map<std::string, CellFile> deferred_;   // Pushed while active
+    size_t pushed_ = 0;
+    bool closed_ = false;
+};
+
+// DirectoryCrawler walks a directory tree on several threads and streams
+// the cells it finds into a CellQueue, so ingest can start on the first
+// cells while the rest of the tree is still being listed. Threads take
+// directories from a shared stack and push the subdirectories they find
+// back onto it; each directory is listed by one thread, so a cell and its
+// updates are grouped from the same listing. Worth it when listing and
+// stat() are slow (NFS), not for CPU.
+class DirectoryCrawler {
+public:
+    DirectoryCrawler(std::string root, bool recursive, int threads);
+
+    // Joins the crawl threads
+    ~DirectoryCrawler();
+
+    // Prevent copying
+    DirectoryCrawler(const DirectoryCrawler&) = delete;
+    DirectoryCrawler& operator=(const DirectoryCrawler&) = delete;
+
+    // Start crawling into queue, which is closed when the crawl finishes
+    void start(CellQueue& queue);
+
+    // Wait for the crawl to finish
+    void join();
+
+private:
+    std::string root_;
+    bool recursive_;
+    int threadCount_;
+    CellQueue* queue_ = nullptr;
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable pendingReady_;
+    std::vector<std::string> pending_;     // Directories not listed yet
+    int listing_ = 0;                      // Directories being listed now
+    std::atomic<int> running_{0};
+
+    // Thread body: list directories until none are pending or being listed
+    void crawl();
+
+    // List one directory: cells go to the queue, subdirectories to pending
+    void listDirectory(const std::string& dir);
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_CRAWLER_HPP
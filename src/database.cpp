@@ -5,14 +5,20 @@
 // Port of Njord's ChartDao.kt and GeoJsonDao.kt
 
 #include "database.hpp"
+#include "copy_utils.hpp"
+#include "geometry.hpp"
+#include "json_utils.hpp"
 #include <pqxx/pqxx>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <cmath>
 
 namespace s57 {
 
-// SQL for schema initialization (matching Njord's up.sql)
+// SQL for table creation (matching Njord's up.sql)
 static const char* SCHEMA_SQL = R"(
 CREATE TABLE IF NOT EXISTS meta (
     key     VARCHAR UNIQUE NOT NULL,
@@ -31,12 +37,14 @@ CREATE TABLE IF NOT EXISTS charts (
     zoom       INTEGER                  NOT NULL,
     covr       GEOMETRY(GEOMETRY, 4326) NOT NULL,
     dsid_props JSONB                    NOT NULL,
-    chart_txt  JSONB                    NOT NULL
+    chart_txt  JSONB                    NOT NULL,
+    min_x      REAL                     NULL,
+    min_y      REAL                     NULL,
+    max_x      REAL                     NULL,
+    max_y      REAL                     NULL,
+    hkey       BIGINT                   NULL
 );
 
-CREATE INDEX IF NOT EXISTS charts_gist ON charts USING GIST (covr);
-CREATE INDEX IF NOT EXISTS charts_idx ON charts (id);
-
 CREATE TABLE IF NOT EXISTS features (
     id        BIGSERIAL PRIMARY KEY,
     layer     VARCHAR                       NOT NULL,
@@ -44,17 +52,375 @@ CREATE TABLE IF NOT EXISTS features (
     props     JSONB                         NOT NULL,
     chart_id  BIGINT REFERENCES charts (id) NOT NULL,
     lnam_refs VARCHAR[]                     NULL,
-    z_range   INT4RANGE                     NOT NULL
+    z_range   INT4RANGE                     NOT NULL,
+    min_x     REAL                          NULL,
+    min_y     REAL                          NULL,
+    max_x     REAL                          NULL,
+    max_y     REAL                          NULL,
+    hkey      BIGINT                        NULL
+);
+
+-- Envelope (rounded outwards) and Hilbert key of the envelope center,
+-- added after version 1
+ALTER TABLE charts ADD COLUMN IF NOT EXISTS min_x REAL NULL,
+                   ADD COLUMN IF NOT EXISTS min_y REAL NULL,
+                   ADD COLUMN IF NOT EXISTS max_x REAL NULL,
+                   ADD COLUMN IF NOT EXISTS max_y REAL NULL,
+                   ADD COLUMN IF NOT EXISTS hkey BIGINT NULL;
+ALTER TABLE features ADD COLUMN IF NOT EXISTS min_x REAL NULL,
+                     ADD COLUMN IF NOT EXISTS min_y REAL NULL,
+                     ADD COLUMN IF NOT EXISTS max_x REAL NULL,
+                     ADD COLUMN IF NOT EXISTS max_y REAL NULL,
+                     ADD COLUMN IF NOT EXISTS hkey BIGINT NULL;
+
+-- Simplified geometry per zoom band, written with --generalize
+-- A band's row replaces features.geom for zooms inside its z_range
+CREATE TABLE IF NOT EXISTS feature_lods (
+    feature_id BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    z_range    INT4RANGE                                         NOT NULL,
+    geom       GEOMETRY(GEOMETRY, 4326)                          NOT NULL
+);
+
+-- Pieces of large areas, written with --subdivide
+-- Spatial lookups hit the small pieces, then join back to the feature
+CREATE TABLE IF NOT EXISTS feature_parts (
+    feature_id BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    part       INTEGER                                           NOT NULL,
+    geom       GEOMETRY(GEOMETRY, 4326)                          NOT NULL
+);
+
+-- LNAM references resolved within each chart
+-- kind is what to_id is to from_id: master, slave or peer (from FFPT_RIND),
+-- or aggregate/association for C_AGGR/C_ASSO members
+CREATE TABLE IF NOT EXISTS feature_links (
+    from_id BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    to_id   BIGINT REFERENCES features (id) ON DELETE CASCADE NOT NULL,
+    kind    VARCHAR                                           NOT NULL
+);
+
+-- Chart quilt: the part of each chart's coverage it owns per zoom band,
+-- where better-scale charts take precedence (ties go to the newer chart)
+CREATE TABLE IF NOT EXISTS chart_quilt (
+    chart_id BIGINT REFERENCES charts (id) ON DELETE CASCADE NOT NULL,
+    z_range  INT4RANGE                                    NOT NULL,
+    geom     GEOMETRY(GEOMETRY, 4326)                     NOT NULL
+);
+
+-- Coverage that changed since the quilt was last updated. Only recorded
+-- once a quilt has been built (meta key 'quilt'); until then the next
+-- update computes the whole quilt anyway
+CREATE TABLE IF NOT EXISTS chart_quilt_dirty (
+    covr GEOMETRY(GEOMETRY, 4326) NOT NULL
+);
+
+CREATE OR REPLACE FUNCTION chart_quilt_mark_dirty() RETURNS trigger AS $$
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM meta WHERE key = 'quilt') THEN
+        RETURN NULL;
+    END IF;
+    IF TG_OP <> 'INSERT' THEN
+        INSERT INTO chart_quilt_dirty (covr) VALUES (OLD.covr);
+    END IF;
+    IF TG_OP <> 'DELETE' THEN
+        INSERT INTO chart_quilt_dirty (covr) VALUES (NEW.covr);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS charts_quilt_dirty ON charts;
+CREATE TRIGGER charts_quilt_dirty
+    AFTER INSERT OR DELETE OR UPDATE OF covr, scale, zoom ON charts
+    FOR EACH ROW EXECUTE FUNCTION chart_quilt_mark_dirty();
+
+-- SOUNDG stored compactly, written with --compact-soundings
+-- Soundings of one source feature share a sounding_attrs row
+CREATE TABLE IF NOT EXISTS sounding_attrs (
+    id       BIGSERIAL PRIMARY KEY,
+    chart_id BIGINT REFERENCES charts (id) ON DELETE CASCADE NOT NULL,
+    props    JSONB                                        NOT NULL,
+    z_range  INT4RANGE                                    NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS soundings (
+    chart_id BIGINT REFERENCES charts (id) ON DELETE CASCADE         NOT NULL,
+    attrs_id BIGINT REFERENCES sounding_attrs (id) ON DELETE CASCADE NOT NULL,
+    geom     GEOMETRY(POINT, 4326)                                   NOT NULL,
+    depth    REAL                    -- NULL if the source point had no Z
+);
+
+-- One row per shard of a sharded ingest (--shard i/N), written when the
+-- shard finishes and merged by --shard-summary
+CREATE TABLE IF NOT EXISTS ingest_shards (
+    run_id      VARCHAR     NOT NULL,
+    shard       INTEGER     NOT NULL,
+    shard_count INTEGER     NOT NULL,
+    host        VARCHAR     NOT NULL,
+    files       INTEGER     NOT NULL,
+    succeeded   INTEGER     NOT NULL,
+    failed      INTEGER     NOT NULL,
+    skipped     INTEGER     NOT NULL,
+    features    BIGINT      NOT NULL,
+    failures    JSONB       NOT NULL,
+    finished_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    PRIMARY KEY (run_id, shard)
 );
 
-CREATE INDEX IF NOT EXISTS features_gist ON features USING GIST (geom);
-CREATE INDEX IF NOT EXISTS features_idx ON features (id);
-CREATE INDEX IF NOT EXISTS features_layer_idx ON features (layer);
-CREATE INDEX IF NOT EXISTS features_zoom_idx ON features USING GIST (z_range);
-CREATE INDEX IF NOT EXISTS features_lnam_idx ON features USING GIN (lnam_refs);
+-- Shared work queue for cooperative ingest (--queue). Processes claim
+-- cells with FOR UPDATE SKIP LOCKED and keep their claims alive with
+-- heartbeats; claims whose heartbeat stops are taken back. Its index
+-- is part of the claim path, so bulk loads leave it in place
+CREATE TABLE IF NOT EXISTS ingest_queue (
+    id          BIGSERIAL   PRIMARY KEY,
+    queue       VARCHAR     NOT NULL,
+    path        VARCHAR     NOT NULL,
+    size        BIGINT      NOT NULL DEFAULT 0,
+    status      VARCHAR     NOT NULL DEFAULT 'pending',
+    attempts    INTEGER     NOT NULL DEFAULT 0,
+    worker      VARCHAR     NULL,
+    heartbeat   TIMESTAMPTZ NULL,
+    features    INTEGER     NULL,
+    error       TEXT        NULL,
+    UNIQUE (queue, path)
+);
+CREATE INDEX IF NOT EXISTS ingest_queue_open_idx ON ingest_queue (queue, size DESC)
+    WHERE status IN ('pending', 'running');
 )";
 
-Database::Database(const std::string& connectionString) {
+// Secondary indexes, kept separate from the tables so that bulk loads can
+// defer them until after the data is in place
+struct IndexDef {
+    const char* name;
+    const char* sql;
+};
+
+static const IndexDef SCHEMA_INDEXES[] = {
+    {"charts_gist",        "CREATE INDEX IF NOT EXISTS charts_gist ON charts USING GIST (covr)"},
+    {"charts_idx",         "CREATE INDEX IF NOT EXISTS charts_idx ON charts (id)"},
+    {"charts_hkey_idx",    "CREATE INDEX IF NOT EXISTS charts_hkey_idx ON charts (hkey)"},
+    {"features_gist",      "CREATE INDEX IF NOT EXISTS features_gist ON features USING GIST (geom)"},
+    {"features_idx",       "CREATE INDEX IF NOT EXISTS features_idx ON features (id)"},
+    {"features_layer_idx", "CREATE INDEX IF NOT EXISTS features_layer_idx ON features (layer)"},
+    {"features_zoom_idx",  "CREATE INDEX IF NOT EXISTS features_zoom_idx ON features USING GIST (z_range)"},
+    {"features_hkey_idx",  "CREATE INDEX IF NOT EXISTS features_hkey_idx ON features (hkey)"},
+    {"features_lnam_idx",  "CREATE INDEX IF NOT EXISTS features_lnam_idx ON features USING GIN (lnam_refs)"},
+    {"feature_lods_gist",  "CREATE INDEX IF NOT EXISTS feature_lods_gist ON feature_lods USING GIST (geom)"},
+    {"feature_lods_feature_idx", "CREATE INDEX IF NOT EXISTS feature_lods_feature_idx ON feature_lods (feature_id)"},
+    {"feature_lods_zoom_idx", "CREATE INDEX IF NOT EXISTS feature_lods_zoom_idx ON feature_lods USING GIST (z_range)"},
+    {"feature_parts_gist", "CREATE INDEX IF NOT EXISTS feature_parts_gist ON feature_parts USING GIST (geom)"},
+    {"feature_parts_feature_idx", "CREATE INDEX IF NOT EXISTS feature_parts_feature_idx ON feature_parts (feature_id)"},
+    {"chart_quilt_gist",   "CREATE INDEX IF NOT EXISTS chart_quilt_gist ON chart_quilt USING GIST (geom)"},
+    {"chart_quilt_chart_idx", "CREATE INDEX IF NOT EXISTS chart_quilt_chart_idx ON chart_quilt (chart_id)"},
+    {"chart_quilt_zoom_idx", "CREATE INDEX IF NOT EXISTS chart_quilt_zoom_idx ON chart_quilt USING GIST (z_range)"},
+    {"feature_links_from_idx", "CREATE INDEX IF NOT EXISTS feature_links_from_idx ON feature_links (from_id)"},
+    {"feature_links_to_idx", "CREATE INDEX IF NOT EXISTS feature_links_to_idx ON feature_links (to_id)"},
+    {"sounding_attrs_chart_idx", "CREATE INDEX IF NOT EXISTS sounding_attrs_chart_idx ON sounding_attrs (chart_id)"},
+    {"soundings_gist",     "CREATE INDEX IF NOT EXISTS soundings_gist ON soundings USING GIST (geom)"},
+    {"soundings_chart_idx", "CREATE INDEX IF NOT EXISTS soundings_chart_idx ON soundings (chart_id)"},
+    {"soundings_attrs_idx", "CREATE INDEX IF NOT EXISTS soundings_attrs_idx ON soundings (attrs_id)"},
+};
+
+std::string Database::stagingDropSql(const std::string& suffix) {
+    std::ostringstream sql;
+    for (const char* table : {"soundings", "sounding_attrs", "links", "parts", "lods", "features", "charts"}) {
+        sql << "DROP TABLE IF EXISTS staging_" << table << "_" << suffix << ";\n";
+    }
+    return sql.str();
+}
+
+std::string Database::stagingTablesSql(const std::string& suffix) {
+    // Geometry and JSON are kept as text so COPY stays cheap; PostGIS
+    // parses them in bulk during the merge. Tables left behind by a killed
+    // session with the same suffix are dropped, so stage ids start clean.
+    std::ostringstream sql;
+    sql << stagingDropSql(suffix)
+        << "CREATE UNLOGGED TABLE staging_charts_" << suffix << " (\n"
+        << "    stage_id   BIGINT PRIMARY KEY,\n"
+        << "    name       VARCHAR NOT NULL,\n"
+        << "    scale      INTEGER NOT NULL,\n"
+        << "    file_name  VARCHAR NOT NULL,\n"
+        << "    updated    VARCHAR NOT NULL,\n"
+        << "    issued     VARCHAR NOT NULL,\n"
+        << "    zoom       INTEGER NOT NULL,\n"
+        << "    covr       TEXT    NOT NULL,\n"
+        << "    dsid_props TEXT    NOT NULL,\n"
+        << "    chart_txt  TEXT    NOT NULL,\n"
+        << "    min_x      REAL    NULL,\n"
+        << "    min_y      REAL    NULL,\n"
+        << "    max_x      REAL    NULL,\n"
+        << "    max_y      REAL    NULL,\n"
+        << "    hkey       BIGINT  NULL\n"
+        << ");\n"
+        << "CREATE UNLOGGED TABLE staging_features_" << suffix << " (\n"
+        << "    stage_id       BIGINT    NOT NULL,\n"
+        << "    chart_stage_id BIGINT    NOT NULL,\n"
+        << "    layer          VARCHAR   NOT NULL,\n"
+        << "    geom           TEXT      NOT NULL,\n"
+        << "    props          TEXT      NOT NULL,\n"
+        << "    lnam_refs      VARCHAR[] NULL,\n"
+        << "    min_z          INTEGER   NOT NULL,\n"
+        << "    max_z          INTEGER   NOT NULL,\n"
+        << "    min_x          REAL      NULL,\n"
+        << "    min_y          REAL      NULL,\n"
+        << "    max_x          REAL      NULL,\n"
+        << "    max_y          REAL      NULL,\n"
+        << "    hkey           BIGINT    NULL\n"
+        << ");\n"
+        << "CREATE UNLOGGED TABLE staging_lods_" << suffix << " (\n"
+        << "    feature_stage_id BIGINT  NOT NULL,\n"
+        << "    min_z            INTEGER NOT NULL,\n"
+        << "    max_z            INTEGER NOT NULL,\n"
+        << "    geom             TEXT    NOT NULL\n"
+        << ");\n"
+        << "CREATE UNLOGGED TABLE staging_parts_" << suffix << " (\n"
+        << "    feature_stage_id BIGINT  NOT NULL,\n"
+        << "    part             INTEGER NOT NULL,\n"
+        << "    geom             TEXT    NOT NULL\n"
+        << ");\n"
+        << "CREATE UNLOGGED TABLE staging_links_" << suffix << " (\n"
+        << "    from_stage_id BIGINT  NOT NULL,\n"
+        << "    to_stage_id   BIGINT  NOT NULL,\n"
+        << "    kind          VARCHAR NOT NULL\n"
+        << ");\n"
+        << "CREATE UNLOGGED TABLE staging_sounding_attrs_" << suffix << " (\n"
+        << "    stage_id       BIGINT  NOT NULL,\n"
+        << "    chart_stage_id BIGINT  NOT NULL,\n"
+        << "    props          TEXT    NOT NULL,\n"
+        << "    min_z          INTEGER NOT NULL,\n"
+        << "    max_z          INTEGER NOT NULL\n"
+        << ");\n"
+        << "CREATE UNLOGGED TABLE staging_soundings_" << suffix << " (\n"
+        << "    attrs_stage_id BIGINT           NOT NULL,\n"
+        << "    lon            DOUBLE PRECISION NOT NULL,\n"
+        << "    lat            DOUBLE PRECISION NOT NULL,\n"
+        << "    depth          REAL\n"
+        << ");\n";
+    return sql.str();
+}
+
+std::string Database::stagingMergeSql(const std::string& suffix) {
+    const std::string charts = "staging_charts_" + suffix;
+    const std::string features = "staging_features_" + suffix;
+    const std::string lods = "staging_lods_" + suffix;
+    const std::string parts = "staging_parts_" + suffix;
+    const std::string featureMap = "staging_map_" + suffix;
+    const std::string links = "staging_links_" + suffix;
+    const std::string soundingAttrs = "staging_sounding_attrs_" + suffix;
+    const std::string soundings = "staging_soundings_" + suffix;
+    const std::string attrsMap = "staging_attrs_map_" + suffix;
+
+    // Replace charts by name, then insert-select everything in one go
+    // Feature ids are drawn up front so child rows can reference them
+    std::ostringstream sql;
+    sql << "DELETE FROM features WHERE chart_id IN "
+        << "(SELECT c.id FROM charts c JOIN " << charts << " s ON s.name = c.name);\n"
+        << "DELETE FROM charts WHERE name IN (SELECT name FROM " << charts << ");\n"
+        << "INSERT INTO charts (name, scale, file_name, updated, issued, zoom, covr, dsid_props, chart_txt,\n"
+        << "                    min_x, min_y, max_x, max_y, hkey)\n"
+        << "SELECT name, scale, file_name, updated, issued, zoom,\n"
+        << "       ST_SetSRID(ST_GeomFromGeoJSON(covr), 4326), dsid_props::jsonb, chart_txt::jsonb,\n"
+        << "       min_x, min_y, max_x, max_y, hkey\n"
+        << "FROM " << charts << " ORDER BY stage_id;\n"
+        << "CREATE TEMP TABLE " << featureMap << " ON COMMIT DROP AS\n"
+        << "SELECT stage_id, nextval(pg_get_serial_sequence('features', 'id')) AS id\n"
+        << "FROM " << features << ";\n"
+        << "INSERT INTO features (id, layer, geom, props, chart_id, lnam_refs, z_range,\n"
+        << "                      min_x, min_y, max_x, max_y, hkey)\n"
+        << "SELECT m.id, f.layer, ST_SetSRID(ST_GeomFromGeoJSON(f.geom), 4326), f.props::jsonb,\n"
+        << "       c.id, f.lnam_refs, int4range(f.min_z, f.max_z),\n"
+        << "       f.min_x, f.min_y, f.max_x, f.max_y, f.hkey\n"
+        << "FROM " << features << " f\n"
+        << "JOIN " << featureMap << " m ON m.stage_id = f.stage_id\n"
+        << "JOIN " << charts << " s ON s.stage_id = f.chart_stage_id\n"
+        << "JOIN charts c ON c.name = s.name;\n"
+        << "INSERT INTO feature_lods (feature_id, z_range, geom)\n"
+        << "SELECT m.id, int4range(l.min_z, l.max_z), ST_SetSRID(ST_GeomFromGeoJSON(l.geom), 4326)\n"
+        << "FROM " << lods << " l\n"
+        << "JOIN " << featureMap << " m ON m.stage_id = l.feature_stage_id;\n"
+        << "INSERT INTO feature_parts (feature_id, part, geom)\n"
+        << "SELECT m.id, p.part, ST_SetSRID(ST_GeomFromGeoJSON(p.geom), 4326)\n"
+        << "FROM " << parts << " p\n"
+        << "JOIN " << featureMap << " m ON m.stage_id = p.feature_stage_id;\n"
+        << "INSERT INTO feature_links (from_id, to_id, kind)\n"
+        << "SELECT mf.id, mt.id, l.kind\n"
+        << "FROM " << links << " l\n"
+        << "JOIN " << featureMap << " mf ON mf.stage_id = l.from_stage_id\n"
+        << "JOIN " << featureMap << " mt ON mt.stage_id = l.to_stage_id;\n"
+        << "CREATE TEMP TABLE " << attrsMap << " ON COMMIT DROP AS\n"
+        << "SELECT stage_id, nextval(pg_get_serial_sequence('sounding_attrs', 'id')) AS id\n"
+        << "FROM " << soundingAttrs << ";\n"
+        << "INSERT INTO sounding_attrs (id, chart_id, props, z_range)\n"
+        << "SELECT m.id, c.id, a.props::jsonb, int4range(a.min_z, a.max_z)\n"
+        << "FROM " << soundingAttrs << " a\n"
+        << "JOIN " << attrsMap << " m ON m.stage_id = a.stage_id\n"
+        << "JOIN " << charts << " s ON s.stage_id = a.chart_stage_id\n"
+        << "JOIN charts c ON c.name = s.name;\n"
+        << "INSERT INTO soundings (chart_id, attrs_id, geom, depth)\n"
+        << "SELECT a.chart_id, a.id, ST_SetSRID(ST_MakePoint(p.lon, p.lat), 4326), p.depth\n"
+        << "FROM " << soundings << " p\n"
+        << "JOIN " << attrsMap << " m ON m.stage_id = p.attrs_stage_id\n"
+        << "JOIN sounding_attrs a ON a.id = m.id;\n"
+        << stagingDropSql(suffix);
+    return sql.str();
+}
+
+std::string Database::quiltUpdateSql(bool rebuild) {
+    // Every chart overlapping a changed area is recomputed: it may have
+    // gained or lost a better-scale neighbour there. Changes aren't tracked
+    // before the first quilt, so that one covers all charts.
+    std::ostringstream sql;
+    sql << "CREATE TEMP TABLE quilt_dirty (covr GEOMETRY) ON COMMIT DROP;\n"
+        << "WITH d AS (DELETE FROM chart_quilt_dirty RETURNING covr)\n"
+        << "INSERT INTO quilt_dirty SELECT covr FROM d;\n"
+        << "CREATE TEMP TABLE quilt_targets ON COMMIT DROP AS\n"
+        << "SELECT c.id, c.zoom, c.scale, c.covr FROM charts c\n";
+    if (!rebuild) {
+        sql << "WHERE NOT EXISTS (SELECT 1 FROM meta WHERE key = 'quilt')\n"
+            << "   OR EXISTS (SELECT 1 FROM quilt_dirty d WHERE ST_Intersects(c.covr, d.covr))";
+    }
+    sql << ";\n"
+        << "DELETE FROM chart_quilt WHERE chart_id IN (SELECT id FROM quilt_targets);\n"
+        // A chart starts at its own zoom; each better-scale overlapping chart
+        // that starts later opens a new band with less owned coverage
+        << "INSERT INTO chart_quilt (chart_id, z_range, geom)\n"
+        << "WITH beaters AS (\n"
+        << "    SELECT t.id AS chart_id, d.zoom, d.covr\n"
+        << "    FROM quilt_targets t\n"
+        << "    JOIN charts d ON d.id <> t.id AND ST_Intersects(d.covr, t.covr)\n"
+        << "    WHERE d.scale < t.scale OR (d.scale = t.scale AND d.id > t.id)\n"
+        << "), bounds AS (\n"
+        << "    SELECT id AS chart_id, zoom AS lo FROM quilt_targets\n"
+        << "    UNION\n"
+        << "    SELECT b.chart_id, b.zoom FROM beaters b\n"
+        << "    JOIN quilt_targets t ON t.id = b.chart_id WHERE b.zoom > t.zoom\n"
+        << "), bands AS (\n"
+        << "    SELECT chart_id, lo, lead(lo) OVER (PARTITION BY chart_id ORDER BY lo) AS hi\n"
+        << "    FROM bounds\n"
+        << "), owned AS (\n"
+        << "    SELECT b.chart_id, int4range(b.lo, b.hi) AS z_range,\n"
+        << "           ST_CollectionExtract(COALESCE(ST_Difference(t.covr,\n"
+        << "               (SELECT ST_Union(x.covr) FROM beaters x\n"
+        << "                WHERE x.chart_id = b.chart_id AND x.zoom <= b.lo)), t.covr), 3) AS geom\n"
+        << "    FROM bands b JOIN quilt_targets t ON t.id = b.chart_id\n"
+        << ")\n"
+        << "SELECT chart_id, z_range, geom FROM owned WHERE NOT ST_IsEmpty(geom);\n"
+        << "INSERT INTO meta VALUES ('quilt', '1') ON CONFLICT (key) DO NOTHING;\n";
+    return sql.str();
+}
+
+std::string Database::schemaSql(bool withIndexes) {
+    std::string sql = SCHEMA_SQL;
+    if (withIndexes) {
+        for (const auto& index : SCHEMA_INDEXES) {
+            sql += index.sql;
+            sql += ";\n";
+        }
+    }
+    return sql;
+}
+
+Database::Database(const std::string& connectionString)
+    : connectionString_(connectionString) {
     try {
         conn_ = std::make_unique<pqxx::connection>(connectionString);
     } catch (const std::exception& e) {
@@ -64,6 +430,8 @@ Database::Database(const std::string& connectionString) {
 }
 
 Database::~Database() {
+    // An unfinished staged chart is rolled back by pqxx
+    chartTxn_.reset();
     if (inTransaction_) {
         try {
             rollbackTransaction();
@@ -71,6 +439,10 @@ Database::~Database() {
     }
 }
 
+const std::string& Database::getConnectionString() const {
+    return connectionString_;
+}
+
 bool Database::isConnected() const {
     return conn_ && conn_->is_open();
 }
@@ -89,14 +461,14 @@ bool Database::execute(const std::string& sql) {
     }
 }
 
-bool Database::initSchema() {
+bool Database::initSchema(bool withIndexes) {
     if (!isConnected()) return false;
 
     try {
         // First ensure PostGIS extension exists
         pqxx::work txn(*conn_);
         txn.exec("CREATE EXTENSION IF NOT EXISTS postgis");
-        txn.exec(SCHEMA_SQL);
+        txn.exec(schemaSql(withIndexes));
         txn.commit();
         return true;
     } catch (const std::exception& e) {
@@ -105,16 +477,124 @@ bool Database::initSchema() {
     }
 }
 
+bool Database::beginBulkLoad(bool unlogged) {
+    if (!initSchema(false)) return false;
+
+    try {
+        pqxx::work txn(*conn_);
+        for (const auto& index : SCHEMA_INDEXES) {
+            txn.exec(std::string("DROP INDEX IF EXISTS ") + index.name);
+        }
+        // Referencing tables have to go unlogged before the ones they reference
+        if (unlogged) {
+            txn.exec("ALTER TABLE soundings SET UNLOGGED");
+            txn.exec("ALTER TABLE sounding_attrs SET UNLOGGED");
+            txn.exec("ALTER TABLE feature_links SET UNLOGGED");
+            txn.exec("ALTER TABLE feature_parts SET UNLOGGED");
+            txn.exec("ALTER TABLE feature_lods SET UNLOGGED");
+            txn.exec("ALTER TABLE features SET UNLOGGED");
+            txn.exec("ALTER TABLE chart_quilt SET UNLOGGED");
+            txn.exec("ALTER TABLE charts SET UNLOGGED");
+        }
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Bulk load setup failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Database::finishBulkLoad(int parallelism) {
+    if (!isConnected()) return false;
+
+    // Build each index on its own connection so the server can work on
+    // several of them at once
+    const size_t indexCount = sizeof(SCHEMA_INDEXES) / sizeof(SCHEMA_INDEXES[0]);
+    const size_t threadCount = std::min(indexCount, static_cast<size_t>(std::max(1, parallelism)));
+    std::atomic<size_t> nextIndex{0};
+    std::atomic<bool> ok{true};
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&]() {
+            try {
+                pqxx::connection conn(connectionString_);
+                for (size_t i = nextIndex++; i < indexCount; i = nextIndex++) {
+                    pqxx::nontransaction txn(conn);
+                    txn.exec(SCHEMA_INDEXES[i].sql);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Index build failed: " << e.what() << std::endl;
+                ok = false;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    try {
+        // Only tables that are actually unlogged get rewritten here
+        pqxx::nontransaction txn(*conn_);
+        txn.exec("ALTER TABLE charts SET LOGGED");
+        txn.exec("ALTER TABLE chart_quilt SET LOGGED");
+        txn.exec("ALTER TABLE features SET LOGGED");
+        txn.exec("ALTER TABLE feature_lods SET LOGGED");
+        txn.exec("ALTER TABLE feature_parts SET LOGGED");
+        txn.exec("ALTER TABLE feature_links SET LOGGED");
+        txn.exec("ALTER TABLE sounding_attrs SET LOGGED");
+        txn.exec("ALTER TABLE soundings SET LOGGED");
+        txn.exec("ANALYZE charts");
+        txn.exec("ANALYZE features");
+        txn.exec("ANALYZE feature_lods");
+        txn.exec("ANALYZE feature_parts");
+        txn.exec("ANALYZE feature_links");
+        txn.exec("ANALYZE sounding_attrs");
+        txn.exec("ANALYZE soundings");
+    } catch (const std::exception& e) {
+        std::cerr << "Bulk load finalization failed: " << e.what() << std::endl;
+        return false;
+    }
+
+    return ok;
+}
+
+namespace {
+    // Bbox columns as query parameters; NULL for an invalid bbox
+    struct BboxParams {
+        std::optional<float> minX;
+        std::optional<float> minY;
+        std::optional<float> maxX;
+        std::optional<float> maxY;
+        std::optional<int64_t> hkey;
+    };
+
+    BboxParams bboxParams(const BoundingBox& bbox, int64_t hkey) {
+        BboxParams params;
+        if (bbox.valid) {
+            params.minX = geometry::floatBelow(bbox.minX);
+            params.minY = geometry::floatBelow(bbox.minY);
+            params.maxX = geometry::floatAbove(bbox.maxX);
+            params.maxY = geometry::floatAbove(bbox.maxY);
+            params.hkey = hkey;
+        }
+        return params;
+    }
+}
+
 std::optional<int64_t> Database::insertChart(const ChartInfo& chart) {
     if (!isConnected()) return std::nullopt;
 
     try {
         pqxx::work txn(*conn_);
         
-        // SQL matching Njord's ChartDao.insertChart()
+        // SQL matching Njord's ChartDao.insertChart(), plus bbox columns
+        BboxParams bbox = bboxParams(chart.bbox, chart.hkey);
         pqxx::result result = txn.exec_params(
-            R"(INSERT INTO charts (name, scale, file_name, updated, issued, zoom, covr, dsid_props, chart_txt) 
-               VALUES ($1, $2, $3, $4, $5, $6, ST_SetSRID(ST_GeomFromGeoJSON($7), 4326), $8::jsonb, $9::jsonb)
+            R"(INSERT INTO charts (name, scale, file_name, updated, issued, zoom, covr, dsid_props, chart_txt,
+                                   min_x, min_y, max_x, max_y, hkey)
+               VALUES ($1, $2, $3, $4, $5, $6, ST_SetSRID(ST_GeomFromGeoJSON($7), 4326), $8::jsonb, $9::jsonb,
+                       $10, $11, $12, $13, $14)
                RETURNING id)",
             chart.name,
             chart.scale,
@@ -124,7 +604,12 @@ std::optional<int64_t> Database::insertChart(const ChartInfo& chart) {
             chart.zoom,
             chart.covrGeoJson,
             chart.dsidProps,
-            chart.chartTxt
+            chart.chartTxt,
+            bbox.minX,
+            bbox.minY,
+            bbox.maxX,
+            bbox.maxY,
+            bbox.hkey
         );
         
         txn.commit();
@@ -162,6 +647,33 @@ std::string Database::lnamRefsToArrayLiteral(const std::vector<std::string>& ref
     return ss.str();
 }
 
+// Insert the generalized variants of a feature
+static void insertLods(pqxx::work& txn, int64_t featureId, const std::vector<GeometryLod>& lods) {
+    for (const auto& lod : lods) {
+        txn.exec_params(
+            "INSERT INTO feature_lods (feature_id, z_range, geom) "
+            "VALUES ($1, int4range($2, $3), ST_SetSRID(ST_GeomFromGeoJSON($4), 4326))",
+            featureId,
+            lod.minZ,
+            lod.maxZ,
+            lod.geomGeoJson
+        );
+    }
+}
+
+// Insert the subdivided pieces of a feature
+static void insertParts(pqxx::work& txn, int64_t featureId, const std::vector<std::string>& parts) {
+    for (size_t i = 0; i < parts.size(); ++i) {
+        txn.exec_params(
+            "INSERT INTO feature_parts (feature_id, part, geom) "
+            "VALUES ($1, $2, ST_SetSRID(ST_GeomFromGeoJSON($3), 4326))",
+            featureId,
+            static_cast<int>(i),
+            parts[i]
+        );
+    }
+}
+
 bool Database::insertFeature(int64_t chartId, const Feature& feature) {
     if (!isConnected()) return false;
 
@@ -172,19 +684,29 @@ bool Database::insertFeature(int64_t chartId, const Feature& feature) {
         
         // SQL matching Njord's GeoJsonDao.insertFeature()
         std::ostringstream sql;
-        sql << "INSERT INTO features (layer, geom, props, chart_id, lnam_refs, z_range) "
+        sql << "INSERT INTO features (layer, geom, props, chart_id, lnam_refs, z_range, "
+            << "min_x, min_y, max_x, max_y, hkey) "
             << "VALUES ($1, ST_SetSRID(ST_GeomFromGeoJSON($2), 4326), $3::jsonb, $4, "
-            << lnamRefsLiteral << ", int4range($5, $6))";
+            << lnamRefsLiteral << ", int4range($5, $6), $7, $8, $9, $10, $11) RETURNING id";
         
-        txn.exec_params(
+        BboxParams bbox = bboxParams(feature.bbox, feature.hkey);
+        pqxx::result result = txn.exec_params(
             sql.str(),
             feature.layer,
             feature.geomGeoJson,
             feature.propsJson,
             chartId,
             feature.minZ,
-            feature.maxZ
+            feature.maxZ,
+            bbox.minX,
+            bbox.minY,
+            bbox.maxX,
+            bbox.maxY,
+            bbox.hkey
         );
+        int64_t featureId = result[0][0].as<int64_t>();
+        insertLods(txn, featureId, feature.lods);
+        insertParts(txn, featureId, feature.parts);
         
         txn.commit();
         return true;
@@ -194,7 +716,8 @@ bool Database::insertFeature(int64_t chartId, const Feature& feature) {
     }
 }
 
-bool Database::insertFeatures(int64_t chartId, const std::vector<Feature>& features) {
+bool Database::insertFeatures(int64_t chartId, const std::vector<Feature>& features,
+                              std::vector<int64_t>* ids) {
     if (!isConnected()) return false;
     if (features.empty()) return true;
 
@@ -205,19 +728,30 @@ bool Database::insertFeatures(int64_t chartId, const std::vector<Feature>& featu
             std::string lnamRefsLiteral = lnamRefsToArrayLiteral(feature.lnamRefs);
             
             std::ostringstream sql;
-            sql << "INSERT INTO features (layer, geom, props, chart_id, lnam_refs, z_range) "
+            sql << "INSERT INTO features (layer, geom, props, chart_id, lnam_refs, z_range, "
+                << "min_x, min_y, max_x, max_y, hkey) "
                 << "VALUES ($1, ST_SetSRID(ST_GeomFromGeoJSON($2), 4326), $3::jsonb, $4, "
-                << lnamRefsLiteral << ", int4range($5, $6))";
+                << lnamRefsLiteral << ", int4range($5, $6), $7, $8, $9, $10, $11) RETURNING id";
             
-            txn.exec_params(
+            BboxParams bbox = bboxParams(feature.bbox, feature.hkey);
+            pqxx::result result = txn.exec_params(
                 sql.str(),
                 feature.layer,
                 feature.geomGeoJson,
                 feature.propsJson,
                 chartId,
                 feature.minZ,
-                feature.maxZ
+                feature.maxZ,
+                bbox.minX,
+                bbox.minY,
+                bbox.maxX,
+                bbox.maxY,
+                bbox.hkey
             );
+            int64_t featureId = result[0][0].as<int64_t>();
+            insertLods(txn, featureId, feature.lods);
+            insertParts(txn, featureId, feature.parts);
+            if (ids) ids->push_back(featureId);
         }
         
         txn.commit();
@@ -228,6 +762,566 @@ bool Database::insertFeatures(int64_t chartId, const std::vector<Feature>& featu
     }
 }
 
+bool Database::beginStaging() {
+    if (!isConnected()) return false;
+
+    try {
+        pqxx::work txn(*conn_);
+        // The backend pid is unique among live sessions, so concurrent
+        // workers (even on other hosts) never share staging tables
+        pqxx::result result = txn.exec("SELECT pg_backend_pid()");
+        std::string suffix = std::to_string(result[0][0].as<int64_t>());
+        txn.exec(stagingTablesSql(suffix));
+        txn.commit();
+        stagingSuffix_ = suffix;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Staging table creation failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+const std::string& Database::getStagingSuffix() const {
+    return stagingSuffix_;
+}
+
+bool Database::beginChart(const ChartInfo& chart) {
+    if (!isConnected()) return false;
+
+    if (stagingSuffix_.empty()) {
+        if (chartExists(chart.name)) {
+            deleteChart(chart.name);
+        }
+        auto chartId = insertChart(chart);
+        if (!chartId.has_value()) return false;
+        currentChartId_ = chartId.value();
+        currentChartName_ = chart.name;
+        chartFeatureIds_.clear();
+        return true;
+    }
+
+    const std::string charts = "staging_charts_" + stagingSuffix_;
+    const std::string stagedFeatures = "staging_features_" + stagingSuffix_;
+
+    try {
+        chartTxn_ = std::make_unique<pqxx::work>(*conn_);
+
+        // A chart staged twice in the same session keeps only the latest copy
+        const std::pair<const char*, const char*> children[] = {
+            {"staging_lods_", "feature_stage_id"},
+            {"staging_parts_", "feature_stage_id"},
+            {"staging_links_", "from_stage_id"},
+        };
+        for (const auto& [child, column] : children) {
+            chartTxn_->exec_params(
+                "DELETE FROM " + std::string(child) + stagingSuffix_ + " WHERE " + column + " IN "
+                "(SELECT f.stage_id FROM " + stagedFeatures + " f JOIN " + charts + " c "
+                "ON c.stage_id = f.chart_stage_id WHERE c.name = $1)",
+                chart.name
+            );
+        }
+        chartTxn_->exec_params(
+            "DELETE FROM staging_soundings_" + stagingSuffix_ + " WHERE attrs_stage_id IN "
+            "(SELECT a.stage_id FROM staging_sounding_attrs_" + stagingSuffix_ + " a JOIN " + charts + " c "
+            "ON c.stage_id = a.chart_stage_id WHERE c.name = $1)",
+            chart.name
+        );
+        chartTxn_->exec_params(
+            "DELETE FROM staging_sounding_attrs_" + stagingSuffix_ + " WHERE chart_stage_id IN "
+            "(SELECT stage_id FROM " + charts + " WHERE name = $1)",
+            chart.name
+        );
+        chartTxn_->exec_params(
+            "DELETE FROM " + stagedFeatures + " WHERE chart_stage_id IN "
+            "(SELECT stage_id FROM " + charts + " WHERE name = $1)",
+            chart.name
+        );
+        chartTxn_->exec_params("DELETE FROM " + charts + " WHERE name = $1", chart.name);
+
+        currentChartId_ = nextStageId_++;
+        chartFeatureIds_.clear();
+        pqxx::stream_to stream(*chartTxn_, charts, pgcopy::CHART_COLUMNS);
+        stream.write_raw_line(pgcopy::chartRow(currentChartId_, chart));
+        stream.complete();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Chart staging failed: " << e.what() << std::endl;
+        chartTxn_.reset();
+        return false;
+    }
+}
+
+bool Database::writeFeatures(const std::vector<Feature>& features) {
+    if (stagingSuffix_.empty()) {
+        return insertFeatures(currentChartId_, features, &chartFeatureIds_);
+    }
+    if (!chartTxn_) return false;
+
+    try {
+        std::vector<std::string> lodRows;
+        std::vector<std::string> partRows;
+        {
+            pqxx::stream_to stream(*chartTxn_, "staging_features_" + stagingSuffix_,
+                                   pgcopy::FEATURE_COLUMNS);
+            for (const auto& feature : features) {
+                // geom is NOT NULL in features; an empty one would fail the merge
+                if (feature.geomGeoJson.empty()) {
+                    chartFeatureIds_.push_back(-1);
+                    continue;
+                }
+                int64_t featureStageId = nextStageId_++;
+                chartFeatureIds_.push_back(featureStageId);
+                stream.write_raw_line(pgcopy::featureRow(featureStageId, currentChartId_, feature));
+                for (const auto& lod : feature.lods) {
+                    lodRows.push_back(pgcopy::lodRow(featureStageId, lod));
+                }
+                for (size_t i = 0; i < feature.parts.size(); ++i) {
+                    partRows.push_back(pgcopy::partRow(featureStageId, static_cast<int>(i), feature.parts[i]));
+                }
+            }
+            stream.complete();
+        }
+        // Only one COPY can be in progress per transaction
+        if (!lodRows.empty()) {
+            pqxx::stream_to stream(*chartTxn_, "staging_lods_" + stagingSuffix_,
+                                   pgcopy::LOD_COLUMNS);
+            for (const auto& row : lodRows) {
+                stream.write_raw_line(row);
+            }
+            stream.complete();
+        }
+        if (!partRows.empty()) {
+            pqxx::stream_to stream(*chartTxn_, "staging_parts_" + stagingSuffix_,
+                                   pgcopy::PART_COLUMNS);
+            for (const auto& row : partRows) {
+                stream.write_raw_line(row);
+            }
+            stream.complete();
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Feature staging failed: " << e.what() << std::endl;
+        chartTxn_.reset();
+        return false;
+    }
+}
+
+bool Database::writeLinks(const std::vector<FeatureLink>& links) {
+    if (!isConnected()) return false;
+
+    // Same table layout either way: feature ids directly, stage ids in staging
+    std::vector<std::string> rows;
+    rows.reserve(links.size());
+    for (const auto& link : links) {
+        if (link.from >= chartFeatureIds_.size() || link.to >= chartFeatureIds_.size()) continue;
+        int64_t fromId = chartFeatureIds_[link.from];
+        int64_t toId = chartFeatureIds_[link.to];
+        if (fromId < 0 || toId < 0) continue;
+        rows.push_back(pgcopy::linkRow(fromId, toId, link.kind));
+    }
+    if (rows.empty()) return true;
+
+    if (stagingSuffix_.empty()) {
+        try {
+            pqxx::work txn(*conn_);
+            pqxx::stream_to stream(txn, "feature_links",
+                                   std::vector<std::string>{"from_id", "to_id", "kind"});
+            for (const auto& row : rows) {
+                stream.write_raw_line(row);
+            }
+            stream.complete();
+            txn.commit();
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Feature link insertion failed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    if (!chartTxn_) return false;
+
+    try {
+        pqxx::stream_to stream(*chartTxn_, "staging_links_" + stagingSuffix_, pgcopy::LINK_COLUMNS);
+        for (const auto& row : rows) {
+            stream.write_raw_line(row);
+        }
+        stream.complete();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Feature link staging failed: " << e.what() << std::endl;
+        chartTxn_.reset();
+        return false;
+    }
+}
+
+bool Database::writeSoundings(const SoundingSet& soundings) {
+    if (!isConnected()) return false;
+
+    if (stagingSuffix_.empty()) {
+        try {
+            pqxx::work txn(*conn_);
+
+            // Attribute rows are few (one per SOUNDG feature); the points go in by COPY
+            std::vector<int64_t> attrIds;
+            attrIds.reserve(soundings.attrs.size());
+            for (const auto& attrs : soundings.attrs) {
+                pqxx::result result = txn.exec_params(
+                    "INSERT INTO sounding_attrs (chart_id, props, z_range) "
+                    "VALUES ($1, $2::jsonb, int4range($3, $4)) RETURNING id",
+                    currentChartId_,
+                    attrs.propsJson,
+                    attrs.minZ,
+                    attrs.maxZ
+                );
+                attrIds.push_back(result[0][0].as<int64_t>());
+            }
+
+            pqxx::stream_to stream(txn, "soundings",
+                                   std::vector<std::string>{"chart_id", "attrs_id", "geom", "depth"});
+            const std::string chartId = std::to_string(currentChartId_);
+            for (const auto& sounding : soundings.soundings) {
+                std::string row = chartId;
+                row += '\t'; row += std::to_string(attrIds[sounding.attrs]);
+                row += "\tSRID=4326;POINT("; row += pgcopy::number(sounding.lon);
+                row += ' '; row += pgcopy::number(sounding.lat);
+                row += ")\t";
+                row += std::isnan(sounding.depth) ? pgcopy::NULL_VALUE : pgcopy::number(sounding.depth);
+                stream.write_raw_line(row);
+            }
+            stream.complete();
+
+            txn.commit();
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Sounding insertion failed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    if (!chartTxn_) return false;
+
+    try {
+        std::vector<int64_t> attrStageIds;
+        attrStageIds.reserve(soundings.attrs.size());
+        {
+            pqxx::stream_to stream(*chartTxn_, "staging_sounding_attrs_" + stagingSuffix_,
+                                   pgcopy::SOUNDING_ATTRS_COLUMNS);
+            for (const auto& attrs : soundings.attrs) {
+                attrStageIds.push_back(nextStageId_++);
+                stream.write_raw_line(pgcopy::soundingAttrsRow(attrStageIds.back(), currentChartId_, attrs));
+            }
+            stream.complete();
+        }
+        {
+            pqxx::stream_to stream(*chartTxn_, "staging_soundings_" + stagingSuffix_,
+                                   pgcopy::SOUNDING_COLUMNS);
+            for (const auto& sounding : soundings.soundings) {
+                stream.write_raw_line(pgcopy::soundingRow(attrStageIds[sounding.attrs], sounding));
+            }
+            stream.complete();
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Sounding staging failed: " << e.what() << std::endl;
+        chartTxn_.reset();
+        return false;
+    }
+}
+
+bool Database::endChart(bool commit) {
+    if (stagingSuffix_.empty()) {
+        // Direct inserts are already committed; drop a partially written chart
+        return commit || deleteChart(currentChartName_);
+    }
+    if (!chartTxn_) return false;
+
+    try {
+        if (commit) {
+            chartTxn_->commit();
+        } else {
+            chartTxn_->abort();
+        }
+        chartTxn_.reset();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Chart staging commit failed: " << e.what() << std::endl;
+        chartTxn_.reset();
+        return false;
+    }
+}
+
+bool Database::mergeStaging(const std::vector<std::string>& suffixes) {
+    if (!isConnected()) return false;
+    if (suffixes.empty()) return true;
+
+    try {
+        // All sessions are swapped in by a single transaction
+        pqxx::work txn(*conn_);
+        for (const auto& suffix : suffixes) {
+            txn.exec(stagingMergeSql(suffix));
+        }
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Staging merge failed: " << e.what() << std::endl;
+    }
+
+    // Nothing was merged; don't leave the staged rows lying around
+    try {
+        pqxx::work txn(*conn_);
+        for (const auto& suffix : suffixes) {
+            txn.exec(stagingDropSql(suffix));
+        }
+        txn.commit();
+    } catch (const std::exception& e) {
+        std::cerr << "Dropping staging tables failed: " << e.what() << std::endl;
+    }
+    return false;
+}
+
+bool Database::updateQuilt(bool rebuild) {
+    if (!isConnected()) return false;
+
+    try {
+        pqxx::work txn(*conn_);
+        txn.exec(quiltUpdateSql(rebuild));
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Quilt update failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Database::recordIngestSummary(const IngestSummary& summary) {
+    if (!isConnected()) return false;
+
+    try {
+        pqxx::work txn(*conn_);
+        // A shard that is run again replaces its previous result
+        txn.exec_params(
+            "INSERT INTO ingest_shards (run_id, shard, shard_count, host, files, succeeded, "
+            "failed, skipped, features, failures) "
+            "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10::jsonb) "
+            "ON CONFLICT (run_id, shard) DO UPDATE SET "
+            "shard_count = EXCLUDED.shard_count, host = EXCLUDED.host, files = EXCLUDED.files, "
+            "succeeded = EXCLUDED.succeeded, failed = EXCLUDED.failed, skipped = EXCLUDED.skipped, "
+            "features = EXCLUDED.features, failures = EXCLUDED.failures, finished_at = now()",
+            summary.runId, summary.shard, summary.shardCount, summary.host, summary.files,
+            summary.succeeded, summary.failed, summary.skipped, summary.features,
+            json::toJsonArray(summary.failures)
+        );
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Recording ingest summary failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<IngestSummary> Database::getIngestSummaries(const std::string& runId) {
+    std::vector<IngestSummary> summaries;
+    if (!isConnected()) return summaries;
+
+    try {
+        pqxx::work txn(*conn_);
+        pqxx::result rows = txn.exec_params(
+            "SELECT shard, shard_count, host, files, succeeded, failed, skipped, features, "
+            "to_char(finished_at, 'YYYY-MM-DD HH24:MI:SS') "
+            "FROM ingest_shards WHERE run_id = $1 ORDER BY shard",
+            runId
+        );
+        pqxx::result failures = txn.exec_params(
+            "SELECT shard, jsonb_array_elements_text(failures) "
+            "FROM ingest_shards WHERE run_id = $1 ORDER BY shard",
+            runId
+        );
+        txn.commit();
+
+        for (const auto& row : rows) {
+            IngestSummary summary;
+            summary.runId = runId;
+            summary.shard = row[0].as<int>();
+            summary.shardCount = row[1].as<int>();
+            summary.host = row[2].as<std::string>();
+            summary.files = row[3].as<int>();
+            summary.succeeded = row[4].as<int>();
+            summary.failed = row[5].as<int>();
+            summary.skipped = row[6].as<int>();
+            summary.features = row[7].as<int64_t>();
+            summary.finishedAt = row[8].as<std::string>();
+            for (const auto& failure : failures) {
+                if (failure[0].as<int>() == summary.shard) {
+                    summary.failures.push_back(failure[1].as<std::string>());
+                }
+            }
+            summaries.push_back(std::move(summary));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Reading ingest summaries failed: " << e.what() << std::endl;
+    }
+    return summaries;
+}
+
+int Database::enqueueCells(const std::string& queue, const std::vector<CellFile>& cells) {
+    if (!isConnected()) return -1;
+
+    try {
+        pqxx::work txn(*conn_);
+        int added = 0;
+        for (const auto& cell : cells) {
+            pqxx::result r = txn.exec_params(
+                "INSERT INTO ingest_queue (queue, path, size) VALUES ($1, $2, $3) "
+                "ON CONFLICT (queue, path) DO NOTHING",
+                queue, cell.path, static_cast<int64_t>(cell.size)
+            );
+            added += static_cast<int>(r.affected_rows());
+        }
+        txn.commit();
+        return added;
+    } catch (const std::exception& e) {
+        std::cerr << "Queueing cells failed: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+std::optional<QueueItem> Database::claimQueueItem(const std::string& queue, const std::string& worker,
+                                                  int leaseSeconds, int maxAttempts, int* open) {
+    if (open) *open = 0;
+    if (!isConnected()) return std::nullopt;
+
+    try {
+        pqxx::work txn(*conn_);
+
+        // Take back claims of workers that stopped sending heartbeats
+        txn.exec_params(
+            "UPDATE ingest_queue SET worker = NULL, "
+            "status = CASE WHEN attempts >= $3 THEN 'failed' ELSE 'pending' END, "
+            "error = CASE WHEN attempts >= $3 THEN 'worker stopped after ' || attempts || ' attempts' END "
+            "WHERE id IN (SELECT id FROM ingest_queue WHERE queue = $1 AND status = 'running' "
+            "AND heartbeat < now() - make_interval(secs => $2) FOR UPDATE SKIP LOCKED)",
+            queue, leaseSeconds, maxAttempts
+        );
+
+        // Largest cells first, so the last cells left to share out are small
+        pqxx::result r = txn.exec_params(
+            "UPDATE ingest_queue SET status = 'running', worker = $2, heartbeat = now(), "
+            "attempts = attempts + 1 "
+            "WHERE id = (SELECT id FROM ingest_queue WHERE queue = $1 AND status = 'pending' "
+            "ORDER BY size DESC, id LIMIT 1 FOR UPDATE SKIP LOCKED) "
+            "RETURNING id, path, attempts",
+            queue, worker
+        );
+
+        std::optional<QueueItem> item;
+        if (!r.empty()) {
+            item = QueueItem{};
+            item->id = r[0][0].as<int64_t>();
+            item->path = r[0][1].as<std::string>();
+            item->attempts = r[0][2].as<int>();
+        } else if (open) {
+            // Cells claimed elsewhere may still come back
+            *open = txn.exec_params(
+                "SELECT count(*) FROM ingest_queue WHERE queue = $1 AND status IN ('pending', 'running')",
+                queue
+            )[0][0].as<int>();
+        }
+        txn.commit();
+        return item;
+    } catch (const std::exception& e) {
+        std::cerr << "Claiming from queue failed: " << e.what() << std::endl;
+        if (open) *open = -1;
+        return std::nullopt;
+    }
+}
+
+bool Database::finishQueueItem(const QueueItem& item, const std::string& worker,
+                               const ProcessingResult& result) {
+    if (!isConnected()) return false;
+
+    try {
+        pqxx::work txn(*conn_);
+        // A claim that was taken back in the meantime belongs to someone else
+        pqxx::result r = txn.exec_params(
+            "UPDATE ingest_queue SET status = $3, worker = NULL, heartbeat = now(), "
+            "features = $4, error = NULLIF($5, '') "
+            "WHERE id = $1 AND worker = $2 AND status = 'running'",
+            item.id, worker, result.success ? "done" : "failed",
+            result.featureCount, result.errorMessage
+        );
+        txn.commit();
+        return r.affected_rows() > 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Finishing queued cell failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Database::heartbeatQueue(const std::string& worker, const std::vector<int64_t>& ids) {
+    if (!isConnected()) return false;
+    if (ids.empty()) return true;
+
+    std::string idArray = "{";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i > 0) idArray += ",";
+        idArray += std::to_string(ids[i]);
+    }
+    idArray += "}";
+
+    try {
+        pqxx::work txn(*conn_);
+        txn.exec_params(
+            "UPDATE ingest_queue SET heartbeat = now() "
+            "WHERE id = ANY($2::bigint[]) AND worker = $1 AND status = 'running'",
+            worker, idArray
+        );
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Queue heartbeat failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<std::pair<std::string, int>> Database::getQueueCounts(const std::string& queue) {
+    std::vector<std::pair<std::string, int>> counts;
+    if (!isConnected()) return counts;
+
+    try {
+        pqxx::work txn(*conn_);
+        pqxx::result rows = txn.exec_params(
+            "SELECT status, count(*) FROM ingest_queue WHERE queue = $1 GROUP BY status ORDER BY status",
+            queue
+        );
+        txn.commit();
+        for (const auto& row : rows) {
+            counts.emplace_back(row[0].as<std::string>(), row[1].as<int>());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Reading queue failed: " << e.what() << std::endl;
+    }
+    return counts;
+}
+
+std::vector<std::pair<std::string, std::string>> Database::getQueueFailures(const std::string& queue) {
+    std::vector<std::pair<std::string, std::string>> failures;
+    if (!isConnected()) return failures;
+
+    try {
+        pqxx::work txn(*conn_);
+        pqxx::result rows = txn.exec_params(
+            "SELECT path, coalesce(error, '') FROM ingest_queue "
+            "WHERE queue = $1 AND status = 'failed' ORDER BY path",
+            queue
+        );
+        txn.commit();
+        for (const auto& row : rows) {
+            failures.emplace_back(row[0].as<std::string>(), row[1].as<std::string>());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Reading queue failed: " << e.what() << std::endl;
+    }
+    return failures;
+}
+
 bool Database::chartExists(const std::string& name) {
     if (!isConnected()) return false;
 
@@ -279,6 +1373,51 @@ bool Database::deleteChart(const std::string& name) {
     }
 }
 
+std::vector<std::pair<int64_t, ChartInfo>> Database::getCharts(bool withCoverage) {
+    std::vector<std::pair<int64_t, ChartInfo>> charts;
+    if (!isConnected()) return charts;
+
+    try {
+        pqxx::work txn(*conn_);
+        // Rows written before the bbox columns existed fall back to the geometry
+        std::string sql =
+            "SELECT id, name, scale, file_name, updated, issued, zoom, "
+            "COALESCE(min_x, ST_XMin(covr)), COALESCE(min_y, ST_YMin(covr)), "
+            "COALESCE(max_x, ST_XMax(covr)), COALESCE(max_y, ST_YMax(covr)), "
+            "COALESCE(hkey, 0), ";
+        sql += withCoverage ? "ST_AsGeoJSON(covr) " : "NULL ";
+        sql += "FROM charts ORDER BY id";
+        pqxx::result result = txn.exec(sql);
+        txn.commit();
+
+        charts.reserve(result.size());
+        for (const auto& row : result) {
+            ChartInfo info;
+            info.name = row[1].as<std::string>();
+            info.scale = row[2].as<int>();
+            info.fileName = row[3].as<std::string>();
+            info.updated = row[4].as<std::string>();
+            info.issued = row[5].as<std::string>();
+            info.zoom = row[6].as<int>();
+            if (!row[7].is_null()) {
+                info.bbox.minX = row[7].as<double>();
+                info.bbox.minY = row[8].as<double>();
+                info.bbox.maxX = row[9].as<double>();
+                info.bbox.maxY = row[10].as<double>();
+                info.bbox.valid = true;
+            }
+            info.hkey = row[11].as<int64_t>();
+            if (!row[12].is_null()) {
+                info.covrGeoJson = row[12].as<std::string>();
+            }
+            charts.emplace_back(row[0].as<int64_t>(), std::move(info));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Chart listing failed: " << e.what() << std::endl;
+    }
+    return charts;
+}
+
 int64_t Database::getChartCount() {
     if (!isConnected()) return 0;
 
@@ -8,6 +8,7 @@
 #define S57_POSTGIS_DATABASE_HPP
 
 #include "types.hpp"
+#include "sink.hpp"
 #include <string>
 #include <vector>
 #include <memory>
@@ -16,19 +17,22 @@
 // Forward declaration
 namespace pqxx {
     class connection;
+    class transaction_base;
 }
 
 namespace s57 {
 
 // Database class for PostGIS operations
 // Port of Njord's ChartDao and GeoJsonDao
-class Database {
+// As a ChartSink it writes charts directly, or into staging tables after
+// beginStaging()
+class Database : public ChartSink {
 public:
     // Constructor with connection string
     explicit Database(const std::string& connectionString);
     
     // Destructor
-    ~Database();
+    ~Database() override;
 
     // Prevent copying
     Database(const Database&) = delete;
@@ -37,8 +41,19 @@ public:
     // Check if connected
     bool isConnected() const;
 
+    // Get the connection string (used to open per-worker connections)
+    const std::string& getConnectionString() const;
+
     // Initialize the database schema
-    bool initSchema();
+    // Secondary indexes are skipped when withIndexes is false
+    bool initSchema(bool withIndexes = true);
+
+    // Prepare for an initial bulk load: create the tables without secondary
+    // indexes (dropping any that exist) and optionally make them UNLOGGED
+    bool beginBulkLoad(bool unlogged);
+
+    // Build the deferred indexes in parallel, restore logging and ANALYZE
+    bool finishBulkLoad(int parallelism);
 
     // Insert a chart and return its ID
     // Port of ChartDao.insertChart()
@@ -49,7 +64,88 @@ public:
     bool insertFeature(int64_t chartId, const Feature& feature);
 
     // Insert multiple features in a batch (for performance)
-    bool insertFeatures(int64_t chartId, const std::vector<Feature>& features);
+    // The new feature ids are appended to ids when given
+    bool insertFeatures(int64_t chartId, const std::vector<Feature>& features,
+                        std::vector<int64_t>* ids = nullptr);
+
+    // Create per-session UNLOGGED staging tables for this connection
+    bool beginStaging();
+
+    // Suffix of this session's staging tables (empty before beginStaging)
+    const std::string& getStagingSuffix() const;
+
+    // ChartSink: replace the chart by name and insert it
+    // In staging mode the chart is COPYed in one transaction up to endChart
+    bool beginChart(const ChartInfo& chart) override;
+
+    // ChartSink: insert (or COPY into staging) features of the current chart
+    bool writeFeatures(const std::vector<Feature>& features) override;
+
+    // ChartSink: insert (or COPY into staging) soundings of the current chart
+    bool writeSoundings(const SoundingSet& soundings) override;
+
+    // ChartSink: insert (or COPY into staging) LNAM links of the current chart
+    bool writeLinks(const std::vector<FeatureLink>& links) override;
+
+    // ChartSink: finish the current chart
+    bool endChart(bool commit) override;
+
+    // Swap the given sessions' staging tables into charts/features
+    // with set-based SQL in a single transaction, then drop them (also
+    // when the merge fails)
+    bool mergeStaging(const std::vector<std::string>& suffixes);
+
+    // Recompute chart_quilt for the charts overlapping coverage that changed
+    // since the last update (tracked by a trigger), or for all charts
+    bool updateQuilt(bool rebuild = false);
+
+    // SQL creating the charts/features schema (without the postgis extension)
+    static std::string schemaSql(bool withIndexes = true);
+
+    // SQL creating the staging tables for a session suffix (replacing any
+    // left over from an earlier session with the same suffix)
+    static std::string stagingTablesSql(const std::string& suffix);
+
+    // SQL dropping the staging tables of a session suffix
+    static std::string stagingDropSql(const std::string& suffix);
+
+    // SQL merging a session's staging tables into charts/features
+    static std::string stagingMergeSql(const std::string& suffix);
+
+    // SQL run by updateQuilt (inside one transaction)
+    static std::string quiltUpdateSql(bool rebuild);
+
+    // Record the result of one shard of a sharded ingest (replaces an
+    // earlier result for the same run and shard)
+    bool recordIngestSummary(const IngestSummary& summary);
+
+    // Results recorded for a run, by shard
+    std::vector<IngestSummary> getIngestSummaries(const std::string& runId);
+
+    // Add cells to a shared ingest queue, leaving out paths it already has
+    // Returns the number added, -1 on error
+    int enqueueCells(const std::string& queue, const std::vector<CellFile>& cells);
+
+    // Claim the next pending cell of a queue for worker, largest first.
+    // Claims whose heartbeat is older than leaseSeconds are taken back
+    // first: requeued, or failed once tried maxAttempts times. When nothing
+    // is claimed, open receives the number of cells still pending or
+    // running elsewhere, or -1 if the queue couldn't be read.
+    std::optional<QueueItem> claimQueueItem(const std::string& queue, const std::string& worker,
+                                            int leaseSeconds, int maxAttempts, int* open = nullptr);
+
+    // Mark a claimed cell done or failed (false if the claim was lost)
+    bool finishQueueItem(const QueueItem& item, const std::string& worker,
+                         const ProcessingResult& result);
+
+    // Refresh the heartbeat of the given claims of worker
+    bool heartbeatQueue(const std::string& worker, const std::vector<int64_t>& ids);
+
+    // Number of cells in a queue by status
+    std::vector<std::pair<std::string, int>> getQueueCounts(const std::string& queue);
+
+    // Failed cells of a queue with their errors
+    std::vector<std::pair<std::string, std::string>> getQueueFailures(const std::string& queue);
 
     // Check if a chart exists by name
     bool chartExists(const std::string& name);
@@ -57,6 +153,9 @@ public:
     // Delete a chart by name (and all its features)
     bool deleteChart(const std::string& name);
 
+    // Get all charts with their ids (coverage GeoJSON only when requested)
+    std::vector<std::pair<int64_t, ChartInfo>> getCharts(bool withCoverage = true);
+
     // Get chart count
     int64_t getChartCount();
 
@@ -73,8 +172,15 @@ public:
     void rollbackTransaction();
 
 private:
+    std::string connectionString_;
     std::unique_ptr<pqxx::connection> conn_;
     bool inTransaction_ = false;
+    std::string stagingSuffix_;
+    int64_t nextStageId_ = 1;
+    int64_t currentChartId_ = 0;
+    std::string currentChartName_;
+    std::vector<int64_t> chartFeatureIds_;   // Id (or stage id) per written feature, -1 if skipped
+    std::unique_ptr<pqxx::transaction_base> chartTxn_;
 
     // Execute a SQL statement
     bool execute(const std::string& sql);
@@ -0,0 +1,308 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Offline COPY dump writer implementation
+
+#include "dump.hpp"
+#include "database.hpp"
+#include "copy_utils.hpp"
+
+#include <cpl_vsi.h>
+
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+// Writes "COPY ... FROM stdin" parts, rotating after rowsPerFile rows
+class CopyDump::PartWriter {
+public:
+    PartWriter(const CopyDump& dump, std::string prefix, std::string table,
+               const std::vector<std::string>& columns)
+        : dump_(dump), prefix_(std::move(prefix)), table_(std::move(table)) {
+        std::ostringstream header;
+        header << "COPY " << table_ << " (";
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (i > 0) header << ", ";
+            header << columns[i];
+        }
+        header << ") FROM stdin;\n";
+        header_ = header.str();
+    }
+
+    ~PartWriter() {
+        close();
+    }
+
+    bool writeRow(const std::string& row, std::vector<std::string>& partFiles) {
+        if (file_ && dump_.options_.rowsPerFile > 0 && rows_ >= dump_.options_.rowsPerFile) {
+            if (!close()) return false;
+        }
+        if (!file_ && !openNext(partFiles)) return false;
+
+        ++rows_;
+        return write(row) && write("\n");
+    }
+
+    bool close() {
+        if (!file_) return true;
+        bool ok = write("\\.\n");
+        ok = VSIFCloseL(file_) == 0 && ok;
+        file_ = nullptr;
+        return ok;
+    }
+
+private:
+    const CopyDump& dump_;
+    std::string prefix_;
+    std::string table_;
+    std::string header_;
+    VSILFILE* file_ = nullptr;
+    size_t rows_ = 0;
+    int partIndex_ = 0;
+
+    bool openNext(std::vector<std::string>& partFiles) {
+        std::ostringstream name;
+        name << prefix_ << "-" << std::setw(6) << std::setfill('0') << partIndex_++ << ".sql";
+        std::string fileName = name.str();
+        std::string path = (fs::path(dump_.options_.directory) / fileName).string();
+        if (dump_.options_.compress) {
+            fileName += ".gz";
+            path = "/vsigzip/" + path + ".gz";
+        }
+
+        file_ = VSIFOpenL(path.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "Failed to create dump part: " << path << std::endl;
+            return false;
+        }
+        partFiles.push_back(fileName);
+        rows_ = 0;
+        return write(header_);
+    }
+
+    bool write(const std::string& data) {
+        return VSIFWriteL(data.data(), 1, data.size(), file_) == data.size();
+    }
+};
+
+CopyDump::CopyDump(const DumpOptions& options) : options_(options) {
+    std::error_code ec;
+    fs::create_directories(options_.directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create dump directory: " << ec.message() << std::endl;
+        return;
+    }
+
+    // Distinct staging tables per dump so several dumps can be loaded at
+    // once; dumps started in the same second (on other hosts) differ in the
+    // random part. Kept short: PostgreSQL truncates names at 63 bytes.
+    std::random_device random;
+    std::ostringstream suffix;
+    suffix << "dump_" << static_cast<long long>(std::time(nullptr)) << "_"
+           << std::hex << std::setfill('0') << std::setw(8) << random()
+           << std::setw(8) << random();
+    suffix_ = suffix.str();
+
+    charts_ = std::make_unique<PartWriter>(*this, "10-charts",
+                                           "staging_charts_" + suffix_, pgcopy::CHART_COLUMNS);
+    features_ = std::make_unique<PartWriter>(*this, "20-features",
+                                             "staging_features_" + suffix_, pgcopy::FEATURE_COLUMNS);
+    lods_ = std::make_unique<PartWriter>(*this, "21-feature-lods",
+                                         "staging_lods_" + suffix_, pgcopy::LOD_COLUMNS);
+    parts_ = std::make_unique<PartWriter>(*this, "22-feature-parts",
+                                          "staging_parts_" + suffix_, pgcopy::PART_COLUMNS);
+    links_ = std::make_unique<PartWriter>(*this, "25-feature-links",
+                                          "staging_links_" + suffix_, pgcopy::LINK_COLUMNS);
+    soundingAttrs_ = std::make_unique<PartWriter>(*this, "23-sounding-attrs",
+                                                  "staging_sounding_attrs_" + suffix_,
+                                                  pgcopy::SOUNDING_ATTRS_COLUMNS);
+    soundings_ = std::make_unique<PartWriter>(*this, "24-soundings",
+                                              "staging_soundings_" + suffix_, pgcopy::SOUNDING_COLUMNS);
+
+    std::string schema = "CREATE EXTENSION IF NOT EXISTS postgis;\n";
+    schema += Database::schemaSql();
+    schema += Database::stagingTablesSql(suffix_);
+    open_ = writeFile("00-schema.sql", schema);
+}
+
+CopyDump::~CopyDump() {
+    if (open_ && !finished_) {
+        finish();
+    }
+}
+
+bool CopyDump::isOpen() const {
+    return open_;
+}
+
+bool CopyDump::writeFile(const std::string& name, const std::string& contents) {
+    std::string path = (fs::path(options_.directory) / name).string();
+    VSILFILE* file = VSIFOpenL(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create dump file: " << path << std::endl;
+        return false;
+    }
+    bool ok = VSIFWriteL(contents.data(), 1, contents.size(), file) == contents.size();
+    ok = VSIFCloseL(file) == 0 && ok;
+    partFiles_.push_back(name);
+    return ok;
+}
+
+// Buffers the rows of the current chart so they reach the parts together
+class CopyDump::DumpSink : public ChartSink {
+public:
+    explicit DumpSink(CopyDump& dump) : dump_(dump) {}
+
+    bool beginChart(const ChartInfo& chart) override {
+        stageId_ = dump_.nextStageId_++;
+        rows_ = ChartRows();
+        rows_.chart = pgcopy::chartRow(stageId_, chart);
+        featureStageIds_.clear();
+        return true;
+    }
+
+    bool writeFeatures(const std::vector<Feature>& features) override {
+        for (const auto& feature : features) {
+            // geom is NOT NULL in features; an empty one would fail the merge
+            if (feature.geomGeoJson.empty()) {
+                featureStageIds_.push_back(-1);
+                continue;
+            }
+            int64_t featureStageId = dump_.nextStageId_++;
+            featureStageIds_.push_back(featureStageId);
+            rows_.features.push_back(pgcopy::featureRow(featureStageId, stageId_, feature));
+            for (const auto& lod : feature.lods) {
+                rows_.lods.push_back(pgcopy::lodRow(featureStageId, lod));
+            }
+            for (size_t i = 0; i < feature.parts.size(); ++i) {
+                rows_.parts.push_back(pgcopy::partRow(featureStageId, static_cast<int>(i), feature.parts[i]));
+            }
+        }
+        return true;
+    }
+
+    bool writeLinks(const std::vector<FeatureLink>& links) override {
+        for (const auto& link : links) {
+            if (link.from >= featureStageIds_.size() || link.to >= featureStageIds_.size()) continue;
+            int64_t fromId = featureStageIds_[link.from];
+            int64_t toId = featureStageIds_[link.to];
+            if (fromId < 0 || toId < 0) continue;
+            rows_.links.push_back(pgcopy::linkRow(fromId, toId, link.kind));
+        }
+        return true;
+    }
+
+    bool writeSoundings(const SoundingSet& soundings) override {
+        std::vector<int64_t> attrStageIds;
+        attrStageIds.reserve(soundings.attrs.size());
+        for (const auto& attrs : soundings.attrs) {
+            attrStageIds.push_back(dump_.nextStageId_++);
+            rows_.soundingAttrs.push_back(pgcopy::soundingAttrsRow(attrStageIds.back(), stageId_, attrs));
+        }
+        for (const auto& sounding : soundings.soundings) {
+            rows_.soundings.push_back(pgcopy::soundingRow(attrStageIds[sounding.attrs], sounding));
+        }
+        return true;
+    }
+
+    bool endChart(bool commit) override {
+        bool ok = !commit || dump_.writeRows(rows_);
+        rows_ = ChartRows();
+        return ok;
+    }
+
+private:
+    CopyDump& dump_;
+    int64_t stageId_ = 0;
+    ChartRows rows_;
+    std::vector<int64_t> featureStageIds_;
+};
+
+std::unique_ptr<ChartSink> CopyDump::openSink() {
+    if (!open_) return nullptr;
+    return std::make_unique<DumpSink>(*this);
+}
+
+bool CopyDump::writeRows(const ChartRows& rows) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_ || finished_) return false;
+
+    if (!charts_->writeRow(rows.chart, partFiles_)) {
+        return false;
+    }
+    const std::pair<PartWriter*, const std::vector<std::string>*> tables[] = {
+        {features_.get(), &rows.features},
+        {lods_.get(), &rows.lods},
+        {parts_.get(), &rows.parts},
+        {links_.get(), &rows.links},
+        {soundingAttrs_.get(), &rows.soundingAttrs},
+        {soundings_.get(), &rows.soundings},
+    };
+    for (const auto& [writer, tableRows] : tables) {
+        for (const auto& row : *tableRows) {
+            if (!writer->writeRow(row, partFiles_)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CopyDump::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_ || finished_) return false;
+    finished_ = true;
+
+    bool ok = charts_->close();
+    ok = features_->close() && ok;
+    ok = lods_->close() && ok;
+    ok = parts_->close() && ok;
+    ok = links_->close() && ok;
+    ok = soundingAttrs_->close() && ok;
+    ok = soundings_->close() && ok;
+
+    ok = writeFile("30-merge.sql",
+                   "BEGIN;\n" + Database::stagingMergeSql(suffix_) + "COMMIT;\n") && ok;
+    if (options_.quilt) {
+        ok = writeFile("40-quilt.sql",
+                       "BEGIN;\n" + Database::quiltUpdateSql(false) + "COMMIT;\n") && ok;
+    }
+
+    // Part names sort in load order
+    std::vector<std::string> parts = partFiles_;
+    std::sort(parts.begin(), parts.end());
+
+    std::ostringstream script;
+    script << "#!/bin/sh\n"
+           << "# Load this dump into PostgreSQL: ./load.sh [psql options]\n"
+           << "set -e\n"
+           << "cd \"$(dirname \"$0\")\"\n"
+           << "for part in";
+    for (const auto& part : parts) {
+        script << " " << part;
+    }
+    script << "; do\n"
+           << "    case \"$part\" in\n"
+           << "        *.gz) gunzip -c \"$part\" ;;\n"
+           << "        *) cat \"$part\" ;;\n"
+           << "    esac | psql -v ON_ERROR_STOP=1 -q \"$@\"\n"
+           << "done\n";
+    ok = writeFile("load.sh", script.str()) && ok;
+
+    std::error_code ec;
+    fs::permissions(fs::path(options_.directory) / "load.sh",
+                    fs::perms::owner_exec | fs::perms::group_exec | fs::perms::others_exec,
+                    fs::perm_options::add, ec);
+
+    return ok;
+}
+
+} // namespace s57
@@ -0,0 +1,109 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Offline COPY dump writer header
+
+#ifndef S57_POSTGIS_DUMP_HPP
+#define S57_POSTGIS_DUMP_HPP
+
+#include "types.hpp"
+#include "sink.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace s57 {
+
+// Dump output options
+struct DumpOptions {
+    std::string directory;      // Output directory (created if missing)
+    bool compress = false;      // gzip each part (.sql.gz)
+    size_t rowsPerFile = 0;     // Start a new part after N rows (0 = never)
+    bool quilt = false;         // Update chart_quilt after the merge
+};
+
+// CopyDump writes parsed charts as a PostgreSQL-loadable dump instead of
+// talking to a live database. The dump uses the same staging tables and
+// merge SQL as Database::stageChart/mergeStaging:
+//
+//   00-schema.sql           schema + staging tables
+//   10-charts-NNNNNN.sql    COPY into the staging charts table
+//   20-features-NNNNNN.sql  COPY into the staging features table
+//   21-feature-lods-NNNNNN.sql  COPY into the staging feature_lods table
+//   22-feature-parts-NNNNNN.sql COPY into the staging feature_parts table
+//   23-sounding-attrs-NNNNNN.sql COPY into the staging sounding_attrs table
+//   24-soundings-NNNNNN.sql     COPY into the staging soundings table
+//   25-feature-links-NNNNNN.sql COPY into the staging feature_links table
+//   30-merge.sql            set-based merge into charts/features
+//   40-quilt.sql            chart_quilt update (with DumpOptions::quilt)
+//   load.sh                 feeds the parts to psql in order
+//
+// Each worker writes through its own sink from openSink(); sinks buffer a
+// chart and append it to the shared parts when the chart ends.
+class CopyDump {
+public:
+    // Constructor - creates the directory and writes the schema part
+    explicit CopyDump(const DumpOptions& options);
+
+    // Destructor - finishes the dump if finish() was not called
+    ~CopyDump();
+
+    // Prevent copying
+    CopyDump(const CopyDump&) = delete;
+    CopyDump& operator=(const CopyDump&) = delete;
+
+    // Check if the dump directory was set up successfully
+    bool isOpen() const;
+
+    // Create a sink for one ingest worker
+    std::unique_ptr<ChartSink> openSink();
+
+    // Close the open parts and write the merge script and load.sh
+    bool finish();
+
+private:
+    // A sequence of COPY part files for one table
+    class PartWriter;
+
+    // Per-worker sink writing into this dump
+    class DumpSink;
+
+    // COPY rows of one chart, per staging table
+    struct ChartRows {
+        std::string chart;
+        std::vector<std::string> features;
+        std::vector<std::string> lods;
+        std::vector<std::string> parts;
+        std::vector<std::string> links;
+        std::vector<std::string> soundingAttrs;
+        std::vector<std::string> soundings;
+    };
+
+    DumpOptions options_;
+    std::string suffix_;
+    bool open_ = false;
+    bool finished_ = false;
+    std::atomic<int64_t> nextStageId_{1};
+    std::vector<std::string> partFiles_;
+    std::unique_ptr<PartWriter> charts_;
+    std::unique_ptr<PartWriter> features_;
+    std::unique_ptr<PartWriter> lods_;
+    std::unique_ptr<PartWriter> parts_;
+    std::unique_ptr<PartWriter> links_;
+    std::unique_ptr<PartWriter> soundingAttrs_;
+    std::unique_ptr<PartWriter> soundings_;
+    std::mutex mutex_;
+
+    // Write a whole file (used for schema, merge and load script)
+    bool writeFile(const std::string& name, const std::string& contents);
+
+    // Append one chart's COPY rows to the parts
+    bool writeRows(const ChartRows& rows);
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_DUMP_HPP
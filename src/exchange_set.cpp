@@ -0,0 +1,489 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// S-57 exchange set catalogue (CATALOG.031) implementation
+//
+// CATALOG.031 is an ISO/IEC 8211 file: a data descriptive record (DDR)
+// describing the fields, then one data record per file in the exchange
+// set with a CATD field (FILE, IMPL, bounds, CRC, ...). Only what's needed
+// to read CATD is implemented here.
+
+#include "exchange_set.hpp"
+
+#include <cpl_vsi.h>
+#include <cpl_string.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+namespace {
+    constexpr char UNIT_TERMINATOR = 0x1f;
+    constexpr char FIELD_TERMINATOR = 0x1e;
+    constexpr size_t LEADER_SIZE = 24;
+
+    struct Field {
+        std::string tag;
+        std::string_view data;
+    };
+
+    // One subfield format from the DDR format controls
+    struct SubfieldFormat {
+        char type = 'A';
+        size_t width = 0;       // Bytes, 0 = delimited by a unit terminator
+    };
+
+    struct FieldDefn {
+        std::vector<std::string> labels;
+        std::vector<SubfieldFormat> formats;
+    };
+
+    bool parseNumber(std::string_view text, size_t& value) {
+        value = 0;
+        if (text.empty()) return false;
+        for (char c : text) {
+            if (c == ' ') continue;
+            if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+            value = value * 10 + static_cast<size_t>(c - '0');
+        }
+        return true;
+    }
+
+    // Split the record at pos into fields and advance pos past it
+    bool readRecord(std::string_view buffer, size_t& pos, char& leaderId,
+                    size_t& fieldControlLength, std::vector<Field>& fields) {
+        fields.clear();
+        if (buffer.size() - pos < LEADER_SIZE) return false;
+        std::string_view leader = buffer.substr(pos, LEADER_SIZE);
+
+        size_t recordLength, fieldAreaStart, sizeLength, sizePosition, sizeTag;
+        if (!parseNumber(leader.substr(0, 5), recordLength) ||
+            !parseNumber(leader.substr(12, 5), fieldAreaStart) ||
+            !parseNumber(leader.substr(20, 1), sizeLength) ||
+            !parseNumber(leader.substr(21, 1), sizePosition) ||
+            !parseNumber(leader.substr(23, 1), sizeTag)) {
+            return false;
+        }
+        if (recordLength < LEADER_SIZE || recordLength > buffer.size() - pos) return false;
+        if (fieldAreaStart > recordLength) return false;
+
+        leaderId = leader[6];
+        if (!parseNumber(leader.substr(10, 2), fieldControlLength)) {
+            fieldControlLength = 0;
+        }
+
+        std::string_view record = buffer.substr(pos, recordLength);
+        size_t entrySize = sizeTag + sizeLength + sizePosition;
+        if (entrySize == 0) return false;
+
+        for (size_t entry = LEADER_SIZE;
+             entry + entrySize <= fieldAreaStart && record[entry] != FIELD_TERMINATOR;
+             entry += entrySize) {
+            size_t length, position;
+            if (!parseNumber(record.substr(entry + sizeTag, sizeLength), length) ||
+                !parseNumber(record.substr(entry + sizeTag + sizeLength, sizePosition), position)) {
+                return false;
+            }
+            if (fieldAreaStart + position + length > recordLength) return false;
+
+            Field field;
+            field.tag = std::string(record.substr(entry, sizeTag));
+            field.data = record.substr(fieldAreaStart + position, length);
+            fields.push_back(field);
+        }
+
+        pos += recordLength;
+        return true;
+    }
+
+    // Split at top-level commas, ignoring those inside parentheses
+    std::vector<std::string_view> splitFormats(std::string_view text) {
+        std::vector<std::string_view> items;
+        int depth = 0;
+        size_t start = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '(') ++depth;
+            if (text[i] == ')') --depth;
+            if (text[i] == ',' && depth == 0) {
+                items.push_back(text.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+        items.push_back(text.substr(start));
+        return items;
+    }
+
+    // Expand format controls like "(A(2),I(10),3A,A(3),4R,2A)"
+    bool expandFormats(std::string_view text, std::vector<SubfieldFormat>& formats) {
+        while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+        while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+        if (text.size() >= 2 && text.front() == '(' && text.back() == ')') {
+            text = text.substr(1, text.size() - 2);
+        }
+
+        for (std::string_view item : splitFormats(text)) {
+            size_t digits = 0;
+            while (digits < item.size() && std::isdigit(static_cast<unsigned char>(item[digits]))) {
+                ++digits;
+            }
+            size_t repeat = 1;
+            if (digits > 0) parseNumber(item.substr(0, digits), repeat);
+            item.remove_prefix(digits);
+            if (item.empty()) return false;
+
+            std::vector<SubfieldFormat> expanded;
+            if (item.front() == '(') {
+                if (!expandFormats(item, expanded)) return false;
+            } else {
+                SubfieldFormat format;
+                format.type = item.front();
+                if (format.type == 'b' && item.size() >= 3) {
+                    // b11, b12, b14, b24, ...: the second digit is the byte count
+                    format.width = static_cast<size_t>(item[2] - '0');
+                } else if (item.size() > 2 && item[1] == '(' && item.back() == ')') {
+                    if (!parseNumber(item.substr(2, item.size() - 3), format.width)) return false;
+                    if (format.type == 'B') format.width /= 8;
+                }
+                expanded.push_back(format);
+            }
+            for (size_t r = 0; r < repeat; ++r) {
+                formats.insert(formats.end(), expanded.begin(), expanded.end());
+            }
+        }
+        return true;
+    }
+
+    // Parse one DDR field description: controls, name, labels, formats
+    bool parseFieldDefn(std::string_view data, size_t fieldControlLength, FieldDefn& defn) {
+        if (data.size() < fieldControlLength) return false;
+        data.remove_prefix(fieldControlLength);
+
+        size_t nameEnd = data.find(UNIT_TERMINATOR);
+        if (nameEnd == std::string_view::npos) return false;
+        data.remove_prefix(nameEnd + 1);
+
+        size_t labelsEnd = data.find(UNIT_TERMINATOR);
+        if (labelsEnd == std::string_view::npos) return false;
+        std::string_view labels = data.substr(0, labelsEnd);
+        data.remove_prefix(labelsEnd + 1);
+
+        size_t start = 0;
+        while (start <= labels.size()) {
+            size_t end = labels.find('!', start);
+            if (end == std::string_view::npos) end = labels.size();
+            defn.labels.emplace_back(labels.substr(start, end - start));
+            start = end + 1;
+        }
+
+        size_t formatsEnd = data.find_first_of(std::string_view("\x1f\x1e", 2));
+        return expandFormats(data.substr(0, formatsEnd), defn.formats);
+    }
+
+    // Decode the subfields of one field instance by label
+    std::map<std::string, std::string> decodeField(std::string_view data, const FieldDefn& defn) {
+        std::map<std::string, std::string> values;
+        size_t pos = 0;
+        size_t count = std::min(defn.labels.size(), defn.formats.size());
+        for (size_t i = 0; i < count && pos < data.size(); ++i) {
+            const SubfieldFormat& format = defn.formats[i];
+            std::string_view value;
+            if (format.width > 0) {
+                value = data.substr(pos, format.width);
+                pos += format.width;
+            } else {
+                size_t end = data.find_first_of(std::string_view("\x1f\x1e", 2), pos);
+                if (end == std::string_view::npos) end = data.size();
+                value = data.substr(pos, end - pos);
+                pos = end + 1;
+            }
+            // Binary subfields aren't needed from CATD
+            if (format.type != 'b' && format.type != 'B') {
+                while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+                values[defn.labels[i]] = std::string(value);
+            }
+        }
+        return values;
+    }
+
+    // Update number from a file extension (".000" -> 0), -1 if not an S-57 cell file
+    int updateNumber(const fs::path& path) {
+        std::string ext = path.extension().string();
+        if (ext.size() != 4) return -1;
+        for (size_t i = 1; i < ext.size(); ++i) {
+            if (!std::isdigit(static_cast<unsigned char>(ext[i]))) return -1;
+        }
+        return std::stoi(ext.substr(1));
+    }
+}
+
+std::vector<CellFile> groupCellFiles(const std::vector<std::pair<std::string, uintmax_t>>& files,
+                                     bool acrossDirectories) {
+    std::map<std::string, CellFile> cells;
+    std::map<std::string, std::vector<std::pair<int, std::string>>> updates;
+    std::map<std::string, uintmax_t> updateSizes;
+
+    for (const auto& [file, size] : files) {
+        fs::path path(file);
+        int update = updateNumber(path);
+        if (update < 0) continue;
+
+        std::string key = acrossDirectories ? path.stem().string()
+                                            : (path.parent_path() / path.stem()).string();
+        if (update == 0) {
+            CellFile& cell = cells[key];
+            cell.path = file;
+            cell.size += size;
+        } else {
+            updates[key].emplace_back(update, file);
+            updateSizes[key] += size;
+        }
+    }
+
+    std::vector<CellFile> result;
+    result.reserve(cells.size());
+    for (auto& [key, cell] : cells) {
+        auto it = updates.find(key);
+        if (it != updates.end()) {
+            std::sort(it->second.begin(), it->second.end());
+            for (auto& [number, path] : it->second) {
+                cell.updates.push_back(std::move(path));
+            }
+            cell.size += updateSizes[key];
+        }
+        result.push_back(std::move(cell));
+    }
+    std::sort(result.begin(), result.end(),
+              [](const CellFile& a, const CellFile& b) { return a.path < b.path; });
+    return result;
+}
+
+std::vector<std::string> findCellUpdates(const std::string& basePath) {
+    std::vector<std::string> updates;
+    fs::path base(basePath);
+    fs::path encRoot = base.parent_path().parent_path();
+
+    // Same lookup as GDAL's S57Reader::FindAndApplyUpdates
+    for (int update = 1; update < 1000; ++update) {
+        char ext[8];
+        std::snprintf(ext, sizeof(ext), ".%03d", update);
+        fs::path sameDir = base;
+        sameDir.replace_extension(ext);
+        fs::path sibling = encRoot / std::to_string(update) / (base.stem().string() + ext);
+
+        VSIStatBufL stat;
+        if (VSIStatL(sameDir.string().c_str(), &stat) == 0) {
+            updates.push_back(sameDir.string());
+        } else if (VSIStatL(sibling.string().c_str(), &stat) == 0) {
+            updates.push_back(sibling.string());
+        } else {
+            break;
+        }
+    }
+    return updates;
+}
+
+CellFile findCell(const std::string& basePath) {
+    CellFile cell;
+    cell.path = basePath;
+    VSIStatBufL stat;
+    if (VSIStatL(basePath.c_str(), &stat) == 0) {
+        cell.size = static_cast<uintmax_t>(stat.st_size);
+    }
+    for (auto& update : findCellUpdates(basePath)) {
+        if (VSIStatL(update.c_str(), &stat) == 0) {
+            cell.size += static_cast<uintmax_t>(stat.st_size);
+        }
+        cell.updates.push_back(std::move(update));
+    }
+    return cell;
+}
+
+std::string findBaseCell(const std::string& filePath) {
+    fs::path path(filePath);
+    if (path.extension() == ".000") return filePath;
+
+    VSIStatBufL stat;
+    fs::path sameDir = path;
+    sameDir.replace_extension(".000");
+    if (VSIStatL(sameDir.string().c_str(), &stat) == 0) return sameDir.string();
+
+    // ENC_ROOT layout: the base cell sits in a sibling of the update's
+    // directory, and findCellUpdates decides whether it reaches this update
+    std::string encRoot = path.parent_path().parent_path().string();
+    char** listing = VSIReadDir(encRoot.c_str());
+    std::vector<std::string> dirs;
+    for (int i = 0; listing && listing[i]; ++i) dirs.emplace_back(listing[i]);
+    CSLDestroy(listing);
+    std::sort(dirs.begin(), dirs.end());
+
+    std::string name = path.stem().string() + ".000";
+    for (const std::string& dir : dirs) {
+        fs::path candidate = fs::path(encRoot) / dir / name;
+        if (VSIStatL(candidate.string().c_str(), &stat) != 0) continue;
+        std::vector<std::string> updates = findCellUpdates(candidate.string());
+        if (std::find(updates.begin(), updates.end(), filePath) != updates.end()) {
+            return candidate.string();
+        }
+    }
+    return "";
+}
+
+std::string findExchangeSetCatalog(const std::string& dir) {
+    for (const std::string& base : {dir, dir + "/ENC_ROOT"}) {
+        for (const char* name : {CATALOG_FILE_NAME, "catalog.031"}) {
+            std::string candidate = base + "/" + name;
+            VSIStatBufL stat;
+            if (VSIStatL(candidate.c_str(), &stat) == 0 && VSI_ISREG(stat.st_mode)) {
+                return candidate;
+            }
+        }
+    }
+    return "";
+}
+
+std::optional<std::vector<CellFile>> readExchangeSetCatalog(const std::string& catalogPath) {
+    // Through VSI so catalogues inside /vsizip/ and /vsitar/ read the same way
+    VSILFILE* in = VSIFOpenL(catalogPath.c_str(), "rb");
+    if (!in) return std::nullopt;
+    std::string buffer;
+    char chunk[65536];
+    size_t count;
+    while ((count = VSIFReadL(chunk, 1, sizeof(chunk), in)) > 0) {
+        buffer.append(chunk, count);
+    }
+    VSIFCloseL(in);
+
+    size_t pos = 0;
+    char leaderId = 0;
+    size_t fieldControlLength = 0;
+    std::vector<Field> fields;
+
+    // Data descriptive record
+    if (!readRecord(buffer, pos, leaderId, fieldControlLength, fields) || leaderId != 'L') {
+        return std::nullopt;
+    }
+    FieldDefn catd;
+    bool haveCatd = false;
+    for (const auto& field : fields) {
+        if (field.tag == "CATD") {
+            haveCatd = parseFieldDefn(field.data, fieldControlLength, catd);
+        }
+    }
+    if (!haveCatd) return std::nullopt;
+
+    // Data records: one CATD per file, paths relative to the catalogue
+    const std::string root = fs::path(catalogPath).parent_path().string();
+    std::vector<std::pair<std::string, uintmax_t>> files;
+
+    // Anything shorter than a leader at the end is padding
+    while (buffer.size() - pos >= LEADER_SIZE) {
+        size_t unusedControlLength;
+        if (!readRecord(buffer, pos, leaderId, unusedControlLength, fields)) {
+            return std::nullopt;
+        }
+        for (const auto& field : fields) {
+            if (field.tag != "CATD") continue;
+
+            auto values = decodeField(field.data, catd);
+            std::string file = values["FILE"];
+            if (file.empty() || values["IMPL"] != "BIN") continue;
+
+            std::replace(file.begin(), file.end(), '\\', '/');
+            file.erase(0, file.find_first_not_of('/'));
+            std::string path = root + "/" + file;
+
+            VSIStatBufL stat;
+            if (VSIStatL(path.c_str(), &stat) != 0) continue;
+            files.emplace_back(path, static_cast<uintmax_t>(stat.st_size));
+        }
+    }
+
+    // ENC_ROOT keeps each update in its own directory, so match by cell name
+    return groupCellFiles(files, true);
+}
+
+bool isArchivePath(const std::string& path) {
+    auto endsWith = [&path](const std::string& suffix) {
+        return path.size() >= suffix.size() &&
+               std::equal(suffix.rbegin(), suffix.rend(), path.rbegin(),
+                          [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); });
+    };
+    return path.rfind("/vsizip/", 0) == 0 || path.rfind("/vsitar/", 0) == 0 ||
+           endsWith(".zip") || endsWith(".tar") || endsWith(".tgz") || endsWith(".tar.gz");
+}
+
+std::string archiveRoot(const std::string& path) {
+    if (path.rfind("/vsizip/", 0) == 0 || path.rfind("/vsitar/", 0) == 0) {
+        return path;
+    }
+    std::error_code ec;
+    std::string absolute = fs::absolute(path, ec).string();
+    if (ec) absolute = path;
+
+    std::string lower = absolute;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    bool zip = lower.size() >= 4 && lower.compare(lower.size() - 4, 4, ".zip") == 0;
+    return (zip ? "/vsizip/" : "/vsitar/") + absolute;
+}
+
+std::vector<CellFile> findArchiveCells(const std::string& path) {
+    const std::string root = archiveRoot(path);
+
+    // A single member, e.g. /vsizip/charts.zip/GB100001.000
+    if (updateNumber(fs::path(root)) == 0) {
+        VSIStatBufL stat;
+        if (VSIStatL(root.c_str(), &stat) != 0) return {};
+        CellFile cell;
+        cell.path = root;
+        cell.size = static_cast<uintmax_t>(stat.st_size);
+        return {cell};
+    }
+
+    // One listing of the archive; it also fills GDAL's per-archive directory
+    // cache, so workers opening members later don't each parse it again
+    char** listing = VSIReadDirRecursive(root.c_str());
+    std::vector<std::string> entries;
+    for (char** entry = listing; entry && *entry; ++entry) {
+        entries.emplace_back(*entry);
+    }
+    CSLDestroy(listing);
+
+    // Prefer the shallowest CATALOG.031 in the archive
+    std::string catalog;
+    for (const auto& entry : entries) {
+        std::string name = fs::path(entry).filename().string();
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        if (name == CATALOG_FILE_NAME &&
+            (catalog.empty() || std::count(entry.begin(), entry.end(), '/') <
+                                std::count(catalog.begin(), catalog.end(), '/'))) {
+            catalog = entry;
+        }
+    }
+    if (!catalog.empty()) {
+        if (auto cells = readExchangeSetCatalog(root + "/" + catalog)) {
+            return std::move(*cells);
+        }
+    }
+
+    std::vector<std::pair<std::string, uintmax_t>> files;
+    for (const auto& entry : entries) {
+        if (updateNumber(fs::path(entry)) < 0) continue;
+        std::string member = root + "/" + entry;
+        VSIStatBufL stat;
+        if (VSIStatL(member.c_str(), &stat) == 0 && VSI_ISREG(stat.st_mode)) {
+            files.emplace_back(member, static_cast<uintmax_t>(stat.st_size));
+        }
+    }
+    return groupCellFiles(files, false);
+}
+
+} // namespace s57
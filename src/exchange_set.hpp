@@ -0,0 +1,74 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// S-57 exchange set catalogue (CATALOG.031) header
+
+#ifndef S57_POSTGIS_EXCHANGE_SET_HPP
+#define S57_POSTGIS_EXCHANGE_SET_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+#include <optional>
+#include <utility>
+#include <cstdint>
+
+namespace s57 {
+
+// Name of the exchange set catalogue file
+inline const char* CATALOG_FILE_NAME = "CATALOG.031";
+
+// Group S-57 files (path, size) into base cells with their updates.
+// Updates are matched to the base cell in the same directory, or by cell
+// name alone when acrossDirectories is set (ENC_ROOT layout). Updates
+// without a base cell are left out; cells are sorted by path.
+std::vector<CellFile> groupCellFiles(const std::vector<std::pair<std::string, uintmax_t>>& files,
+                                     bool acrossDirectories);
+
+// Update files GDAL applies to a base cell, in order, exactly as GDAL
+// finds them: CELL.00N next to the base cell, else the ENC_ROOT layout
+// where update N sits in a sibling directory named N
+// (.../CELL/0/CELL.000, .../CELL/1/CELL.001). Stops at the first missing
+// update.
+std::vector<std::string> findCellUpdates(const std::string& basePath);
+
+// A base cell with the updates findCellUpdates finds and their combined
+// size, for cells known only by path
+CellFile findCell(const std::string& basePath);
+
+// Base cell (.000) that GDAL would apply the given update to, found the
+// same way as findCellUpdates: CELL.000 next to the update, else a
+// CELL.000 in a sibling directory whose update chain reaches it (ENC_ROOT
+// layout). A base cell path is returned as is; returns an empty string if
+// no base cell picks the update up.
+std::string findBaseCell(const std::string& filePath);
+
+// Find the catalogue of an exchange set rooted at dir (in dir itself or in
+// its ENC_ROOT), returning an empty string if there is none
+std::string findExchangeSetCatalog(const std::string& dir);
+
+// Read the cells listed in an exchange set catalogue. Each CATD record
+// names one file; base cells (.000) are returned with their updates
+// (.001, ...) and the combined size, which costs one stat() per listed
+// file instead of a directory walk. Updates without a base cell in the
+// set and files missing on disk are left out.
+// Returns nullopt if the catalogue can't be read as ISO 8211.
+std::optional<std::vector<CellFile>> readExchangeSetCatalog(const std::string& catalogPath);
+
+// Check if a path is a zip or tar archive (.zip, .tar, .tgz, .tar.gz) or
+// already a GDAL /vsizip/ or /vsitar/ path
+bool isArchivePath(const std::string& path);
+
+// GDAL virtual filesystem path of an archive ("/vsizip//abs/charts.zip")
+std::string archiveRoot(const std::string& path);
+
+// Find the cells inside an archive without unpacking it, from its
+// CATALOG.031 when there is one, otherwise from the archive listing.
+// Paths are /vsizip/ or /vsitar/ paths that S57 opens directly; each open
+// gets its own handle into the archive, so workers read members in
+// parallel. Random access into .tar.gz is slow, prefer .zip or .tar.
+std::vector<CellFile> findArchiveCells(const std::string& path);
+
+} // namespace s57
+
+#endif // S57_POSTGIS_EXCHANGE_SET_HPP
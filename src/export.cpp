@@ -0,0 +1,268 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// GeoPackage / FlatGeobuf export implementation
+
+#include "export.hpp"
+#include "json_utils.hpp"
+
+#include <gdal.h>
+#include <ogrsf_frmts.h>
+#include <cpl_string.h>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+namespace {
+    struct GeometryDeleter {
+        void operator()(OGRGeometry* geometry) const {
+            OGRGeometryFactory::destroyGeometry(geometry);
+        }
+    };
+
+    using GeometryPtr = std::unique_ptr<OGRGeometry, GeometryDeleter>;
+
+    GeometryPtr geometryFromGeoJson(const std::string& geoJson) {
+        if (geoJson.empty()) return nullptr;
+        return GeometryPtr(OGRGeometryFactory::createFromGeoJson(geoJson.c_str()));
+    }
+
+    bool addField(OGRLayer* layer, const char* name, OGRFieldType type, bool json = false) {
+        OGRFieldDefn field(name, type);
+        if (json) {
+            field.SetSubType(OFSTJSON);
+        }
+        return layer->CreateField(&field) == OGRERR_NONE;
+    }
+}
+
+// Parses geometry for the current chart as batches arrive and writes the
+// whole chart in one transaction on endChart
+class VectorExport::ExportSink : public ChartSink {
+public:
+    explicit ExportSink(VectorExport& output) : output_(output) {}
+
+    bool beginChart(const ChartInfo& chart) override {
+        chart_ = chart;
+        pending_.clear();
+
+        // Written rows can't be replaced in a stream, so a chart name that
+        // comes again (the same cell listed twice) keeps its first copy
+        {
+            std::lock_guard<std::mutex> lock(output_.mutex_);
+            duplicate_ = !output_.chartNames_.insert(chart.name).second;
+        }
+        if (duplicate_) {
+            std::cerr << "Warning: chart " << chart.name << " already exported, skipping "
+                      << chart.fileName << std::endl;
+            return true;
+        }
+
+        chartGeometry_ = geometryFromGeoJson(chart.covrGeoJson);
+        return true;
+    }
+
+    bool writeFeatures(const std::vector<Feature>& features) override {
+        if (duplicate_) return true;
+        for (const auto& feature : features) {
+            GeometryPtr geometry = geometryFromGeoJson(feature.geomGeoJson);
+            if (!geometry) continue;
+            pending_.push_back({feature.layer, feature.propsJson,
+                                feature.lnamRefs.empty() ? std::string() : json::toJsonArray(feature.lnamRefs),
+                                feature.minZ, feature.maxZ, std::move(geometry)});
+        }
+        return true;
+    }
+
+    bool endChart(bool commit) override {
+        bool ok = duplicate_ || !commit || write();
+        if (!duplicate_ && (!commit || !ok)) {
+            // Nothing of it was written; let another copy take the name
+            std::lock_guard<std::mutex> lock(output_.mutex_);
+            output_.chartNames_.erase(chart_.name);
+        }
+        duplicate_ = false;
+        pending_.clear();
+        chartGeometry_.reset();
+        return ok;
+    }
+
+private:
+    struct PendingFeature {
+        std::string layer;
+        std::string props;
+        std::string lnamRefs;
+        int minZ;
+        int maxZ;
+        GeometryPtr geometry;
+    };
+
+    VectorExport& output_;
+    ChartInfo chart_;
+    bool duplicate_ = false;
+    GeometryPtr chartGeometry_;
+    std::vector<PendingFeature> pending_;
+
+    bool write() {
+        std::lock_guard<std::mutex> lock(output_.mutex_);
+        if (!output_.dataset_) return false;
+
+        // GeoPackage is far faster with one transaction per chart;
+        // FlatGeobuf has no transactions and simply streams
+        bool inTransaction = output_.dataset_->StartTransaction() == OGRERR_NONE;
+        bool ok = true;
+
+        int64_t chartId = output_.nextChartId_++;
+        OGRFeature* chartFeature = OGRFeature::CreateFeature(output_.chartsLayer_->GetLayerDefn());
+        chartFeature->SetField("id", static_cast<GIntBig>(chartId));
+        chartFeature->SetField("name", chart_.name.c_str());
+        chartFeature->SetField("scale", chart_.scale);
+        chartFeature->SetField("file_name", chart_.fileName.c_str());
+        chartFeature->SetField("updated", chart_.updated.c_str());
+        chartFeature->SetField("issued", chart_.issued.c_str());
+        chartFeature->SetField("zoom", chart_.zoom);
+        chartFeature->SetField("dsid_props", chart_.dsidProps.c_str());
+        chartFeature->SetField("chart_txt", chart_.chartTxt.c_str());
+        if (chartGeometry_) {
+            chartFeature->SetGeometryDirectly(chartGeometry_.release());
+        }
+        ok = output_.chartsLayer_->CreateFeature(chartFeature) == OGRERR_NONE;
+        OGRFeature::DestroyFeature(chartFeature);
+
+        OGRFeatureDefn* defn = output_.featuresLayer_->GetLayerDefn();
+        for (auto& pending : pending_) {
+            if (!ok) break;
+            OGRFeature* feature = OGRFeature::CreateFeature(defn);
+            feature->SetField("layer", pending.layer.c_str());
+            feature->SetField("props", pending.props.c_str());
+            feature->SetField("chart_id", static_cast<GIntBig>(chartId));
+            if (!pending.lnamRefs.empty()) {
+                feature->SetField("lnam_refs", pending.lnamRefs.c_str());
+            }
+            feature->SetField("min_z", pending.minZ);
+            feature->SetField("max_z", pending.maxZ);
+            feature->SetGeometryDirectly(pending.geometry.release());
+            ok = output_.featuresLayer_->CreateFeature(feature) == OGRERR_NONE;
+            OGRFeature::DestroyFeature(feature);
+        }
+
+        if (inTransaction) {
+            if (ok) {
+                ok = output_.dataset_->CommitTransaction() == OGRERR_NONE;
+            } else {
+                output_.dataset_->RollbackTransaction();
+            }
+        }
+        if (!ok) {
+            std::cerr << "Export of chart " << chart_.name << " failed" << std::endl;
+        }
+        return ok;
+    }
+};
+
+VectorExport::VectorExport(const std::string& path) : path_(path) {
+    GDALAllRegister();
+
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    driverName_ = extension == ".gpkg" ? "GPKG" : "FlatGeobuf";
+    GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(driverName_.c_str());
+    if (!driver) {
+        std::cerr << "GDAL driver not available: " << driverName_ << std::endl;
+        return;
+    }
+
+    // FlatGeobuf writes one .fgb per layer into a directory, which the
+    // driver creates itself and refuses if it already exists
+    fs::path target(path);
+    if (!target.has_filename()) {
+        target = target.parent_path();  // "region-fgb/"
+    }
+    fs::path parent = target.parent_path();
+    if (!parent.empty()) {
+        std::error_code ec;
+        fs::create_directories(parent, ec);
+    }
+
+    dataset_ = driver->Create(path.c_str(), 0, 0, 0, GDT_Unknown, nullptr);
+    if (!dataset_) {
+        std::cerr << "Failed to create export: " << path << std::endl;
+        return;
+    }
+
+    if (!createLayers()) {
+        std::cerr << "Failed to create export layers in " << path << std::endl;
+        GDALClose(dataset_);
+        dataset_ = nullptr;
+    }
+}
+
+VectorExport::~VectorExport() {
+    finish();
+}
+
+bool VectorExport::isOpen() const {
+    return dataset_ != nullptr;
+}
+
+const std::string& VectorExport::getDriverName() const {
+    return driverName_;
+}
+
+bool VectorExport::createLayers() {
+    OGRSpatialReference wgs84;
+    wgs84.SetWellKnownGeogCS("WGS84");
+    wgs84.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+
+    CPLStringList options;
+    options.SetNameValue("SPATIAL_INDEX", "YES");
+    if (driverName_ == "GPKG") {
+        options.SetNameValue("GEOMETRY_NAME", "geom");
+    }
+
+    chartsLayer_ = dataset_->CreateLayer("charts", &wgs84, wkbUnknown, options.List());
+    featuresLayer_ = dataset_->CreateLayer("features", &wgs84, wkbUnknown, options.List());
+    if (!chartsLayer_ || !featuresLayer_) return false;
+
+    return addField(chartsLayer_, "id", OFTInteger64)
+        && addField(chartsLayer_, "name", OFTString)
+        && addField(chartsLayer_, "scale", OFTInteger)
+        && addField(chartsLayer_, "file_name", OFTString)
+        && addField(chartsLayer_, "updated", OFTString)
+        && addField(chartsLayer_, "issued", OFTString)
+        && addField(chartsLayer_, "zoom", OFTInteger)
+        && addField(chartsLayer_, "dsid_props", OFTString, true)
+        && addField(chartsLayer_, "chart_txt", OFTString, true)
+        && addField(featuresLayer_, "layer", OFTString)
+        && addField(featuresLayer_, "props", OFTString, true)
+        && addField(featuresLayer_, "chart_id", OFTInteger64)
+        && addField(featuresLayer_, "lnam_refs", OFTString, true)
+        && addField(featuresLayer_, "min_z", OFTInteger)
+        && addField(featuresLayer_, "max_z", OFTInteger);
+}
+
+std::unique_ptr<ChartSink> VectorExport::openSink() {
+    if (!isOpen()) return nullptr;
+    return std::make_unique<ExportSink>(*this);
+}
+
+bool VectorExport::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dataset_) return false;
+
+    GDALClose(dataset_);
+    dataset_ = nullptr;
+    chartsLayer_ = nullptr;
+    featuresLayer_ = nullptr;
+    return true;
+}
+
+} // namespace s57
@@ -0,0 +1,79 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// GeoPackage / FlatGeobuf export header
+
+#ifndef S57_POSTGIS_EXPORT_HPP
+#define S57_POSTGIS_EXPORT_HPP
+
+#include "types.hpp"
+#include "sink.hpp"
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <unordered_set>
+
+// Forward declarations for GDAL types
+class GDALDataset;
+class OGRLayer;
+
+namespace s57 {
+
+// VectorExport writes the charts/features model into a file-based vector
+// format through GDAL, for deployments without PostGIS:
+//
+//   <name>.gpkg   GeoPackage with "charts" and "features" tables (R-tree index;
+//                 the extension is matched in any case)
+//   <directory>   FlatGeobuf charts.fgb and features.fgb (packed Hilbert R-tree)
+//
+// Output is written in a single streaming pass. Each worker writes through
+// its own sink from openSink(); sinks parse geometry in parallel and append
+// whole charts under a lock. Unlike the database, the export can't replace
+// a chart: the first chart of a name is kept and later ones are skipped.
+// A FlatGeobuf output directory must not exist yet.
+class VectorExport {
+public:
+    // Constructor - creates the output dataset and its layers
+    explicit VectorExport(const std::string& path);
+
+    // Destructor - finishes the export if finish() was not called
+    ~VectorExport();
+
+    // Prevent copying
+    VectorExport(const VectorExport&) = delete;
+    VectorExport& operator=(const VectorExport&) = delete;
+
+    // Check if the output was created successfully
+    bool isOpen() const;
+
+    // Name of the GDAL driver in use
+    const std::string& getDriverName() const;
+
+    // Create a sink for one ingest worker
+    std::unique_ptr<ChartSink> openSink();
+
+    // Close the dataset (builds the FlatGeobuf spatial index)
+    bool finish();
+
+private:
+    // Per-worker sink writing into this export
+    class ExportSink;
+
+    std::string path_;
+    std::string driverName_;
+    GDALDataset* dataset_ = nullptr;
+    OGRLayer* chartsLayer_ = nullptr;
+    OGRLayer* featuresLayer_ = nullptr;
+    std::atomic<int64_t> nextChartId_{1};
+    std::unordered_set<std::string> chartNames_;   // Exported or being exported
+    std::mutex mutex_;
+
+    // Create the charts and features layers with their fields
+    bool createLayers();
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_EXPORT_HPP
@@ -0,0 +1,441 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Geometry encode stage utilities implementation
+
+#include "geometry.hpp"
+
+#include <ogr_geometry.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace s57 {
+namespace geometry {
+
+namespace {
+    constexpr double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+
+    // Snaps coordinates and formats them with just enough decimals
+    class QuantizedWriter {
+    public:
+        QuantizedWriter(double gridSize, double zGridSize)
+            : gridSize_(gridSize), zGridSize_(zGridSize)
+            , digits_(decimalsFor(gridSize)), zDigits_(decimalsFor(zGridSize)) {}
+
+        bool write(const OGRGeometry* geometry, std::string& out) const {
+            switch (wkbFlatten(geometry->getGeometryType())) {
+                case wkbPoint: {
+                    auto point = static_cast<const OGRPoint*>(geometry);
+                    if (point->IsEmpty()) return false;
+                    out += "{\"type\":\"Point\",\"coordinates\":";
+                    writePosition(snap(point->getX(), point->getY(), point->getZ(), point->Is3D()), out);
+                    out += '}';
+                    return true;
+                }
+                case wkbLineString: {
+                    std::string body;
+                    if (!writeCurve(static_cast<const OGRSimpleCurve*>(geometry), 2, body)) return false;
+                    out += "{\"type\":\"LineString\",\"coordinates\":" + body + '}';
+                    return true;
+                }
+                case wkbPolygon: {
+                    std::string body;
+                    if (!writePolygon(static_cast<const OGRPolygon*>(geometry), body)) return false;
+                    out += "{\"type\":\"Polygon\",\"coordinates\":" + body + '}';
+                    return true;
+                }
+                case wkbMultiPoint:
+                case wkbMultiLineString:
+                case wkbMultiPolygon:
+                    return writeMulti(static_cast<const OGRGeometryCollection*>(geometry), out);
+                case wkbGeometryCollection: {
+                    auto collection = static_cast<const OGRGeometryCollection*>(geometry);
+                    std::string members;
+                    for (int i = 0; i < collection->getNumGeometries(); ++i) {
+                        std::string member;
+                        if (!write(collection->getGeometryRef(i), member)) continue;
+                        if (!members.empty()) members += ',';
+                        members += member;
+                    }
+                    if (members.empty()) return false;
+                    out += "{\"type\":\"GeometryCollection\",\"geometries\":[" + members + "]}";
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+    private:
+        struct Position {
+            double x;
+            double y;
+            double z;
+            bool hasZ;
+
+            bool operator==(const Position& other) const {
+                return x == other.x && y == other.y;
+            }
+        };
+
+        static int decimalsFor(double gridSize) {
+            if (gridSize <= 0.0) return 0;
+            return std::max(0, static_cast<int>(std::ceil(-std::log10(gridSize) - 1e-9)));
+        }
+
+        Position snap(double x, double y, double z, bool hasZ) const {
+            return {snapToGrid(x, gridSize_), snapToGrid(y, gridSize_), snapToGrid(z, zGridSize_), hasZ};
+        }
+
+        static void writeNumber(double value, int digits, std::string& out) {
+            char buffer[64];
+            int length = std::snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+            if (length <= 0) return;
+
+            // Trim trailing zeros (and the point) and avoid "-0"
+            std::string text(buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+            if (text.find('.') != std::string::npos) {
+                text.erase(text.find_last_not_of('0') + 1);
+                if (text.back() == '.') text.pop_back();
+            }
+            if (text == "-0") text = "0";
+            out += text;
+        }
+
+        void writePosition(const Position& position, std::string& out) const {
+            out += '[';
+            writeNumber(position.x, digits_, out);
+            out += ',';
+            writeNumber(position.y, digits_, out);
+            if (position.hasZ) {
+                out += ',';
+                writeNumber(position.z, zGridSize_ > 0.0 ? zDigits_ : 6, out);
+            }
+            out += ']';
+        }
+
+        bool writeCurve(const OGRSimpleCurve* curve, int minPoints, std::string& out) const {
+            std::vector<Position> positions;
+            positions.reserve(curve->getNumPoints());
+            bool hasZ = curve->Is3D();
+            for (int i = 0; i < curve->getNumPoints(); ++i) {
+                Position position = snap(curve->getX(i), curve->getY(i), hasZ ? curve->getZ(i) : 0.0, hasZ);
+                if (!positions.empty() && positions.back() == position) continue;
+                positions.push_back(position);
+            }
+
+            // A line needs two distinct vertices, a closed ring three plus the closing one
+            if (static_cast<int>(positions.size()) < minPoints) return false;
+
+            out += '[';
+            for (size_t i = 0; i < positions.size(); ++i) {
+                if (i > 0) out += ',';
+                writePosition(positions[i], out);
+            }
+            out += ']';
+            return true;
+        }
+
+        bool writePolygon(const OGRPolygon* polygon, std::string& out) const {
+            std::string rings;
+            if (!polygon->getExteriorRing() || !writeCurve(polygon->getExteriorRing(), 4, rings)) {
+                return false;
+            }
+            for (int i = 0; i < polygon->getNumInteriorRings(); ++i) {
+                std::string ring;
+                if (writeCurve(polygon->getInteriorRing(i), 4, ring)) {
+                    rings += ',' + ring;
+                }
+            }
+            out += '[' + rings + ']';
+            return true;
+        }
+
+        bool writeMulti(const OGRGeometryCollection* collection, std::string& out) const {
+            auto type = wkbFlatten(collection->getGeometryType());
+            std::string parts;
+            for (int i = 0; i < collection->getNumGeometries(); ++i) {
+                const OGRGeometry* part = collection->getGeometryRef(i);
+                std::string body;
+                bool written = false;
+                if (type == wkbMultiPoint) {
+                    auto point = static_cast<const OGRPoint*>(part);
+                    if (!point->IsEmpty()) {
+                        writePosition(snap(point->getX(), point->getY(), point->getZ(), point->Is3D()), body);
+                        written = true;
+                    }
+                } else if (type == wkbMultiLineString) {
+                    written = writeCurve(static_cast<const OGRSimpleCurve*>(part), 2, body);
+                } else {
+                    written = writePolygon(static_cast<const OGRPolygon*>(part), body);
+                }
+                if (!written) continue;
+                if (!parts.empty()) parts += ',';
+                parts += body;
+            }
+            if (parts.empty()) return false;
+
+            const char* name = type == wkbMultiPoint ? "MultiPoint"
+                             : type == wkbMultiLineString ? "MultiLineString" : "MultiPolygon";
+            out += std::string("{\"type\":\"") + name + "\",\"coordinates\":[" + parts + "]}";
+            return true;
+        }
+
+        double gridSize_;
+        double zGridSize_;
+        int digits_;
+        int zDigits_;
+    };
+}
+
+double pixelSize(int zoom) {
+    return 360.0 / (256.0 * std::pow(2.0, zoom));
+}
+
+int vertexCount(const OGRGeometry* geometry) {
+    if (!geometry) return 0;
+
+    switch (wkbFlatten(geometry->getGeometryType())) {
+        case wkbPoint:
+            return 1;
+        case wkbLineString:
+        case wkbLinearRing:
+            return static_cast<const OGRSimpleCurve*>(geometry)->getNumPoints();
+        case wkbPolygon: {
+            auto polygon = static_cast<const OGRPolygon*>(geometry);
+            int count = vertexCount(polygon->getExteriorRing());
+            for (int i = 0; i < polygon->getNumInteriorRings(); ++i) {
+                count += vertexCount(polygon->getInteriorRing(i));
+            }
+            return count;
+        }
+        case wkbMultiPoint:
+        case wkbMultiLineString:
+        case wkbMultiPolygon:
+        case wkbGeometryCollection: {
+            auto collection = static_cast<const OGRGeometryCollection*>(geometry);
+            int count = 0;
+            for (int i = 0; i < collection->getNumGeometries(); ++i) {
+                count += vertexCount(collection->getGeometryRef(i));
+            }
+            return count;
+        }
+        default:
+            return 0;
+    }
+}
+
+std::vector<Simplified> generalize(const OGRGeometry* geometry, int minZ, int chartZoom) {
+    std::vector<Simplified> variants;
+    if (!geometry || geometry->getDimension() < 1) return variants;
+    if (chartZoom <= minZ) return variants;
+
+    int vertices = vertexCount(geometry);
+    if (vertices < LOD_MIN_VERTICES) return variants;
+
+    // A degree of longitude shrinks towards the poles, so the same pixel
+    // covers fewer degrees there
+    OGREnvelope envelope;
+    geometry->getEnvelope(&envelope);
+    double latitude = (envelope.MinY + envelope.MaxY) / 2.0 * DEG_TO_RAD;
+    double latScale = std::max(0.01, std::cos(latitude));
+
+    int previous = vertices;
+    for (int maxZ = chartZoom; maxZ > minZ; maxZ -= LOD_BAND_SIZE) {
+        int bandMinZ = std::max(minZ, maxZ - LOD_BAND_SIZE);
+        double tolerance = pixelSize(maxZ - 1) * latScale / 2.0;
+
+        OGRGeometry* simplified = geometry->SimplifyPreserveTopology(tolerance);
+        if (!simplified) break;  // GDAL built without GEOS
+
+        int count = vertexCount(simplified);
+        if (simplified->IsEmpty() || count * 4 > previous * 3) {
+            OGRGeometryFactory::destroyGeometry(simplified);
+            continue;
+        }
+
+        variants.push_back({bandMinZ, maxZ, simplified});
+        previous = count;
+    }
+    return variants;
+}
+
+namespace {
+    // Deeper splits only happen for degenerate input (e.g. a huge number
+    // of vertices on one spot); each level can double the clipping work
+    constexpr int SUBDIVIDE_MAX_DEPTH = 12;
+
+    OGRPolygon* makeBox(double minX, double minY, double maxX, double maxY) {
+        auto ring = new OGRLinearRing();
+        ring->addPoint(minX, minY);
+        ring->addPoint(maxX, minY);
+        ring->addPoint(maxX, maxY);
+        ring->addPoint(minX, maxY);
+        ring->addPoint(minX, minY);
+        auto box = new OGRPolygon();
+        box->addRingDirectly(ring);
+        return box;
+    }
+
+    void subdivideInto(const OGRGeometry* geometry, int maxVertices, int depth,
+                       std::vector<OGRGeometry*>& pieces) {
+        switch (wkbFlatten(geometry->getGeometryType())) {
+            case wkbPolygon:
+                break;
+            case wkbMultiPolygon:
+            case wkbGeometryCollection: {
+                // Clipping can leave lines and points on the cut; only areas are kept
+                auto collection = static_cast<const OGRGeometryCollection*>(geometry);
+                for (int i = 0; i < collection->getNumGeometries(); ++i) {
+                    subdivideInto(collection->getGeometryRef(i), maxVertices, depth, pieces);
+                }
+                return;
+            }
+            default:
+                return;
+        }
+
+        if (geometry->IsEmpty()) return;
+        if (vertexCount(geometry) <= maxVertices || depth >= SUBDIVIDE_MAX_DEPTH) {
+            pieces.push_back(geometry->clone());
+            return;
+        }
+
+        // Halve across the longer side of the envelope
+        OGREnvelope envelope;
+        geometry->getEnvelope(&envelope);
+        bool splitX = envelope.MaxX - envelope.MinX >= envelope.MaxY - envelope.MinY;
+        double middle = splitX ? (envelope.MinX + envelope.MaxX) / 2.0
+                               : (envelope.MinY + envelope.MaxY) / 2.0;
+
+        OGRPolygon* halves[2];
+        if (splitX) {
+            halves[0] = makeBox(envelope.MinX, envelope.MinY, middle, envelope.MaxY);
+            halves[1] = makeBox(middle, envelope.MinY, envelope.MaxX, envelope.MaxY);
+        } else {
+            halves[0] = makeBox(envelope.MinX, envelope.MinY, envelope.MaxX, middle);
+            halves[1] = makeBox(envelope.MinX, middle, envelope.MaxX, envelope.MaxY);
+        }
+
+        for (OGRPolygon* half : halves) {
+            OGRGeometry* clipped = geometry->Intersection(half);
+            if (clipped) {
+                subdivideInto(clipped, maxVertices, depth + 1, pieces);
+                OGRGeometryFactory::destroyGeometry(clipped);
+            }
+            OGRGeometryFactory::destroyGeometry(half);
+        }
+    }
+}
+
+std::vector<OGRGeometry*> subdivide(const OGRGeometry* geometry, int maxVertices) {
+    std::vector<OGRGeometry*> pieces;
+    if (!geometry || maxVertices <= 0 || geometry->getDimension() != 2) return pieces;
+    maxVertices = std::max(maxVertices, SUBDIVIDE_MIN_VERTICES);
+    if (vertexCount(geometry) <= maxVertices) return pieces;
+
+    subdivideInto(geometry, maxVertices, 0, pieces);
+    return pieces;
+}
+
+BoundingBox envelope(const OGRGeometry* geometry) {
+    BoundingBox bbox;
+    if (!geometry || geometry->IsEmpty()) return bbox;
+
+    OGREnvelope env;
+    geometry->getEnvelope(&env);
+    bbox.minX = env.MinX;
+    bbox.minY = env.MinY;
+    bbox.maxX = env.MaxX;
+    bbox.maxY = env.MaxY;
+    bbox.valid = true;
+    return bbox;
+}
+
+void expand(BoundingBox& box, const BoundingBox& other) {
+    if (!other.valid) return;
+    if (!box.valid) {
+        box = other;
+        return;
+    }
+    box.minX = std::min(box.minX, other.minX);
+    box.minY = std::min(box.minY, other.minY);
+    box.maxX = std::max(box.maxX, other.maxX);
+    box.maxY = std::max(box.maxY, other.maxY);
+}
+
+int64_t hilbertKey(double lon, double lat) {
+    const uint64_t side = uint64_t{1} << HILBERT_ORDER;
+    auto cell = [side](double value, double min, double max) {
+        double t = (value - min) / (max - min);
+        t = std::min(std::max(t, 0.0), 1.0);
+        return std::min(static_cast<uint64_t>(t * static_cast<double>(side)), side - 1);
+    };
+    uint64_t x = cell(lon, -180.0, 180.0);
+    uint64_t y = cell(lat, -90.0, 90.0);
+
+    // Classic xy -> d conversion, rotating the quadrant at each level
+    uint64_t d = 0;
+    for (uint64_t s = side / 2; s > 0; s /= 2) {
+        uint64_t rx = (x & s) ? 1 : 0;
+        uint64_t ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return static_cast<int64_t>(d);
+}
+
+int64_t hilbertKey(const BoundingBox& bbox) {
+    if (!bbox.valid) return 0;
+    return hilbertKey((bbox.minX + bbox.maxX) / 2.0, (bbox.minY + bbox.maxY) / 2.0);
+}
+
+float floatBelow(double value) {
+    float f = static_cast<float>(value);
+    if (static_cast<double>(f) > value) {
+        f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+    }
+    return f;
+}
+
+float floatAbove(double value) {
+    float f = static_cast<float>(value);
+    if (static_cast<double>(f) < value) {
+        f = std::nextafter(f, std::numeric_limits<float>::infinity());
+    }
+    return f;
+}
+
+double snapToGrid(double value, double gridSize) {
+    if (gridSize <= 0.0) return value;
+    return std::round(value / gridSize) * gridSize;
+}
+
+double comfGridSize(long comf) {
+    return 1.0 / static_cast<double>(comf > 0 ? comf : 10000000L);
+}
+
+double decimalGridSize(int precision) {
+    return std::pow(10.0, -std::max(0, precision));
+}
+
+std::string toQuantizedGeoJson(const OGRGeometry* geometry, double gridSize, double zGridSize) {
+    std::string out;
+    if (!geometry) return out;
+
+    QuantizedWriter writer(gridSize, zGridSize);
+    if (!writer.write(geometry, out)) out.clear();
+    return out;
+}
+
+} // namespace geometry
+} // namespace s57
@@ -0,0 +1,100 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Geometry encode stage utilities header
+
+#ifndef S57_POSTGIS_GEOMETRY_HPP
+#define S57_POSTGIS_GEOMETRY_HPP
+
+#include "types.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Forward declarations for GDAL types
+class OGRGeometry;
+
+namespace s57 {
+namespace geometry {
+
+// Zoom levels per generalization band below the chart zoom
+constexpr int LOD_BAND_SIZE = 2;
+
+// Geometries with fewer vertices are never generalized
+constexpr int LOD_MIN_VERTICES = 32;
+
+// A simplified copy of a geometry for zooms [minZ, maxZ)
+// The caller owns the geometry (destroy with OGRGeometryFactory)
+struct Simplified {
+    int minZ;
+    int maxZ;
+    OGRGeometry* geometry;
+};
+
+// Size of a 256px tile pixel in degrees at the equator
+double pixelSize(int zoom);
+
+// Total number of vertices in a geometry
+int vertexCount(const OGRGeometry* geometry);
+
+// Build simplified variants of a WGS84 line or area geometry for the zoom
+// bands between minZ and the chart zoom, where it is drawn at full
+// resolution. Each band uses half a pixel at its highest zoom (corrected
+// for latitude) as tolerance; bands that don't save a quarter of the
+// vertices are skipped.
+std::vector<Simplified> generalize(const OGRGeometry* geometry, int minZ, int chartZoom);
+
+// Smallest useful subdivide limit: a clipped piece is at least a closed
+// four-corner ring (5 vertices)
+constexpr int SUBDIVIDE_MIN_VERTICES = 5;
+
+// Split an area geometry into polygons of at most maxVertices vertices each
+// by recursively halving its envelope, like PostGIS ST_Subdivide. Returns
+// no pieces if the geometry is not an area or is already small enough.
+// Halving stops after 12 levels (4096 pieces), so pieces of degenerate
+// input may stay above the limit. maxVertices below SUBDIVIDE_MIN_VERTICES
+// is raised to it. The caller owns the pieces (destroy with
+// OGRGeometryFactory).
+std::vector<OGRGeometry*> subdivide(const OGRGeometry* geometry, int maxVertices);
+
+// Bits per axis of the Hilbert curve; keys fit in a non-negative BIGINT
+constexpr int HILBERT_ORDER = 31;
+
+// Envelope of a geometry (invalid if it is empty)
+BoundingBox envelope(const OGRGeometry* geometry);
+
+// Grow box to also cover other (invalid boxes are ignored)
+void expand(BoundingBox& box, const BoundingBox& other);
+
+// Position of a lon/lat on a Hilbert curve over the whole globe
+int64_t hilbertKey(double lon, double lat);
+
+// Hilbert key of a bounding box center (0 if invalid)
+int64_t hilbertKey(const BoundingBox& bbox);
+
+// Nearest float not above / not below a double, so REAL bbox columns still
+// contain the exact envelope
+float floatBelow(double value);
+float floatAbove(double value);
+
+// Grid step in degrees for a COMF coordinate multiplication factor
+// (S-57 stores coordinates as integers scaled by COMF, default 10^7)
+double comfGridSize(long comf);
+
+// Grid step in degrees for a number of decimal places
+double decimalGridSize(int precision);
+
+// Round a value to the nearest multiple of gridSize (0 keeps it as is)
+double snapToGrid(double value, double gridSize);
+
+// Write a geometry as compact GeoJSON with X/Y snapped to gridSize and Z
+// to zGridSize (0 keeps Z as is). Consecutive vertices that collapse onto
+// the same grid point are removed; lines and rings left degenerate are
+// dropped. Returns an empty string if nothing remains.
+std::string toQuantizedGeoJson(const OGRGeometry* geometry, double gridSize, double zGridSize);
+
+} // namespace geometry
+} // namespace s57
+
+#endif // S57_POSTGIS_GEOMETRY_HPP
@@ -5,20 +5,39 @@
 // Port of Njord's ChartIngest.kt
 
 #include "ingest.hpp"
+#include "exchange_set.hpp"
 #include "s57.hpp"
+#include "geometry.hpp"
 #include <iostream>
 #include <filesystem>
 #include <thread>
 #include <mutex>
 #include <queue>
 #include <condition_variable>
+#include <memory>
+#include <algorithm>
+#include <cctype>
 
 namespace fs = std::filesystem;
 
 namespace s57 {
 
+namespace {
+    // Directory listing threads; they wait on filesystem metadata, not CPU,
+    // so this doesn't follow the worker count
+    constexpr int CRAWLER_THREADS = 8;
+}
+
+ChartIngest::ChartIngest(SinkFactory sinkFactory) 
+    : sinkFactory_(std::move(sinkFactory)) {
+}
+
 ChartIngest::ChartIngest(Database& database) 
-    : database_(database) {
+    : ChartIngest([connectionString = database.getConnectionString()]() -> std::unique_ptr<ChartSink> {
+          auto workerDatabase = std::make_unique<Database>(connectionString);
+          if (!workerDatabase->isConnected()) return nullptr;
+          return workerDatabase;
+      }) {
 }
 
 void ChartIngest::setWorkerCount(int count) {
@@ -33,55 +52,128 @@ void ChartIngest::setVerbose(bool verbose) {
     verbose_ = verbose;
 }
 
+void ChartIngest::setEncodeOptions(const EncodeOptions& options) {
+    encodeOptions_ = options;
+}
+
+void ChartIngest::setJournal(IngestJournal* journal) {
+    journal_ = journal;
+}
+
+void ChartIngest::setMemoryBudget(MemoryBudget* budget) {
+    memoryBudget_ = budget;
+}
+
+
 std::vector<std::string> ChartIngest::findS57Files(const std::string& path, bool recursive) {
     std::vector<std::string> files;
+    for (auto& cell : findCells(path, recursive)) {
+        files.push_back(std::move(cell.path));
+    }
+    return files;
+}
+
+std::vector<CellFile> ChartIngest::findCells(const std::string& path, bool recursive) {
+    std::vector<CellFile> cells;
+    
+    // Zip/tar exchange sets are read in place through GDAL's /vsizip/ and /vsitar/
+    if (isArchivePath(path)) {
+        return findArchiveCells(path);
+    }
     
     fs::path inputPath(path);
     
     if (!fs::exists(inputPath)) {
-        return files;
+        return cells;
     }
     
     if (fs::is_regular_file(inputPath)) {
-        // Single file
+        // Single file (GDAL finds its updates next to it)
         if (inputPath.extension() == ".000") {
-            files.push_back(inputPath.string());
+            cells.push_back(findCell(inputPath.string()));
         }
-        return files;
+        return cells;
     }
     
     if (!fs::is_directory(inputPath)) {
-        return files;
+        return cells;
     }
     
-    // Directory
+    // Exchange set: one catalogue read instead of a tree walk
+    std::string catalog = findExchangeSetCatalog(path);
+    if (!catalog.empty()) {
+        if (auto listed = readExchangeSetCatalog(catalog)) {
+            return std::move(*listed);
+        }
+        std::cerr << "Warning: Could not read " << catalog
+                  << ", scanning the directory instead" << std::endl;
+    }
+    
+    // Directory: S-57 base cells and updates (.000 - .999)
+    std::vector<std::pair<std::string, uintmax_t>> files;
+    auto addEntry = [&files](const fs::directory_entry& entry) {
+        if (!entry.is_regular_file()) return;
+        std::string ext = entry.path().extension().string();
+        if (ext.size() == 4 && std::all_of(ext.begin() + 1, ext.end(),
+                                           [](unsigned char c) { return std::isdigit(c); })) {
+            files.emplace_back(entry.path().string(), entry.file_size());
+        }
+    };
+    
     if (recursive) {
         for (const auto& entry : fs::recursive_directory_iterator(inputPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".000") {
-                files.push_back(entry.path().string());
-            }
+            addEntry(entry);
         }
     } else {
         for (const auto& entry : fs::directory_iterator(inputPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".000") {
-                files.push_back(entry.path().string());
-            }
+            addEntry(entry);
         }
     }
     
-    // Sort for consistent ordering
-    std::sort(files.begin(), files.end());
-    
-    return files;
+    // Sorted by path for consistent ordering
+    return groupCellFiles(files, false);
 }
 
 ProcessingResult ChartIngest::processFile(const std::string& filePath) {
+    auto sink = sinkFactory_();
+    if (!sink) {
+        ProcessingResult result;
+        result.fileName = fs::path(filePath).filename().string();
+        result.errorMessage = "Failed to open output";
+        return result;
+    }
+    CellFile cell;
+    cell.path = filePath;
+    return processFile(cell, *sink);
+}
+
+ProcessingResult ChartIngest::processFile(const CellFile& cell, ChartSink& sink) {
+    const std::string& filePath = cell.path;
     ProcessingResult result;
     result.fileName = fs::path(filePath).filename().string();
     
+    // Skip charts a previous run already committed unchanged
+    uint64_t contentHash = 0;
+    if (journal_) {
+        contentHash = IngestJournal::contentHash(filePath, encodeOptions_);
+        if (journal_->isDone(filePath, contentHash)) {
+            result.success = true;
+            result.skipped = true;
+            return result;
+        }
+    }
+    
     try {
+        // Wait for room before GDAL reads the cell and its features are built
+        uintmax_t fileBytes = cell.size;
+        if (memoryBudget_ && fileBytes == 0) {
+            fileBytes = findCell(filePath).size;
+        }
+        MemoryReservation reservation(memoryBudget_, memoryBudget_ ? memoryBudget_->estimate(fileBytes) : 0);
+        
         // Open and parse the S-57 file
         S57 s57(filePath);
+        s57.setEncodeOptions(encodeOptions_);
         
         if (!s57.isOpen()) {
             result.success = false;
@@ -98,46 +190,103 @@ ProcessingResult ChartIngest::processFile(const std::string& filePath) {
                       << " (scale 1:" << chartInfo.scale << ")" << std::endl;
         }
         
-        // Check if chart already exists
-        if (database_.chartExists(chartInfo.name)) {
-            if (verbose_) {
-                std::cout << "  Updating existing chart: " << chartInfo.name << std::endl;
+        // Parse everything before touching the sink
+        auto features = s57.getAllFeatures();
+        result.featureCount = static_cast<int>(features.size());
+
+        SoundingSet soundings;
+        if (encodeOptions_.compactSoundings) {
+            soundings = s57.getSoundings();
+            result.featureCount += static_cast<int>(soundings.soundings.size());
+        }
+
+        // Replace the estimate by what was actually built; the open dataset
+        // still holds about the cell's size
+        if (memoryBudget_) {
+            size_t parsedBytes = fileBytes + featureBytes(features) + soundingBytes(soundings);
+            memoryBudget_->observe(fileBytes, parsedBytes);
+            reservation.resize(parsedBytes);
+        }
+
+        // Rows reach the heap in write order, so writing them along the
+        // Hilbert curve keeps each tile's rows on few pages
+        if (encodeOptions_.spatialOrder) {
+            std::stable_sort(features.begin(), features.end(),
+                             [](const Feature& a, const Feature& b) { return a.hkey < b.hkey; });
+            std::vector<std::pair<int64_t, Sounding>> keyed;
+            keyed.reserve(soundings.soundings.size());
+            for (const auto& sounding : soundings.soundings) {
+                keyed.emplace_back(geometry::hilbertKey(sounding.lon, sounding.lat), sounding);
+            }
+            std::stable_sort(keyed.begin(), keyed.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (size_t i = 0; i < keyed.size(); ++i) {
+                soundings.soundings[i] = keyed[i].second;
+            }
+        }
+
+        // Links refer to positions, so resolve them in final write order
+        auto links = S57::resolveLinks(features);
+        
+        if (verbose_) {
+            std::cout << "  Found " << features.size() << " features" << std::endl;
+            if (encodeOptions_.compactSoundings) {
+                std::cout << "  Found " << soundings.soundings.size() << " soundings" << std::endl;
             }
-            database_.deleteChart(chartInfo.name);
         }
         
-        // Insert chart
-        auto chartIdOpt = database_.insertChart(chartInfo);
-        if (!chartIdOpt.has_value()) {
+        if (!sink.beginChart(chartInfo)) {
             result.success = false;
             result.errorMessage = "Failed to insert chart";
             return result;
         }
         
-        int64_t chartId = chartIdOpt.value();
-        
-        // Get all features
-        auto features = s57.getAllFeatures();
-        result.featureCount = static_cast<int>(features.size());
-        
-        if (verbose_) {
-            std::cout << "  Found " << features.size() << " features" << std::endl;
-        }
-        
-        // Insert features in batches
+        // Write features in batches
         const size_t batchSize = 1000;
         for (size_t i = 0; i < features.size(); i += batchSize) {
             size_t end = std::min(i + batchSize, features.size());
             std::vector<Feature> batch(
-                features.begin() + static_cast<long>(i),
-                features.begin() + static_cast<long>(end)
+                std::make_move_iterator(features.begin() + static_cast<long>(i)),
+                std::make_move_iterator(features.begin() + static_cast<long>(end))
             );
             
-            if (!database_.insertFeatures(chartId, batch)) {
+            // The sink encodes the batch into a buffer of about its size;
+            // both are freed once it is written
+            size_t batchBytes = memoryBudget_ ? featureBytes(batch) : 0;
+            reservation.resize(reservation.bytes() + batchBytes);
+            
+            if (!sink.writeFeatures(batch)) {
+                sink.endChart(false);
                 result.success = false;
                 result.errorMessage = "Failed to insert features";
                 return result;
             }
+            reservation.resize(reservation.bytes() - std::min(reservation.bytes(), 2 * batchBytes));
+        }
+        
+        if (!soundings.soundings.empty() && !sink.writeSoundings(soundings)) {
+            sink.endChart(false);
+            result.success = false;
+            result.errorMessage = "Failed to insert soundings";
+            return result;
+        }
+        
+        if (!links.empty() && !sink.writeLinks(links)) {
+            sink.endChart(false);
+            result.success = false;
+            result.errorMessage = "Failed to insert feature links";
+            return result;
+        }
+        
+        if (!sink.endChart(true)) {
+            result.success = false;
+            result.errorMessage = "Failed to finish chart";
+            return result;
+        }
+        
+        // Only after the commit, so a journaled chart is always in the output
+        if (journal_ && !journal_->record(filePath, contentHash, chartInfo.name)) {
+            std::cerr << "Warning: Failed to journal " << result.fileName << std::endl;
         }
         
         result.success = true;
@@ -151,50 +300,216 @@ ProcessingResult ChartIngest::processFile(const std::string& filePath) {
 }
 
 std::vector<ProcessingResult> ChartIngest::processFiles(const std::vector<std::string>& files) {
-    std::vector<ProcessingResult> results;
-    results.reserve(files.size());
+    std::vector<CellFile> cells(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        cells[i].path = files[i];
+    }
+    return processCells(cells);
+}
+
+std::vector<ProcessingResult> ChartIngest::processCells(const std::vector<CellFile>& files) {
+    std::vector<ProcessingResult> results(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        results[i].fileName = fs::path(files[i].path).filename().string();
+        results[i].errorMessage = "Not processed";
+    }
     
-    processedCount_ = 0;
-    successCount_ = 0;
-    failCount_ = 0;
-    totalFeatures_ = 0;
+    resetStatistics();
     
     int total = static_cast<int>(files.size());
+    int threadCount = std::min(workerCount_, std::max(1, total));
+    
+    std::atomic<size_t> nextFile{0};
+    std::atomic<int> sinkFailures{0};
+    
+    // Each worker pulls files from a shared index and writes through its
+    // own sink
+    auto worker = [&](int workerIndex) {
+        std::unique_ptr<ChartSink> sink = sinkFactory_();
+        if (!sink) {
+            std::cerr << "Worker " << workerIndex << ": failed to open output" << std::endl;
+            // The others take its share; if there are none, nothing is ingested
+            if (++sinkFailures < threadCount) return;
+            outputFailed_ = true;
+            for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+                std::lock_guard<std::mutex> lock(progressMutex_);
+                results[i].errorMessage = "Failed to open output";
+                finishFile(results[i], total);
+            }
+            return;
+        }
+        
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+            ProcessingResult result = processFile(files[i], *sink);
+            
+            std::lock_guard<std::mutex> lock(progressMutex_);
+            finishFile(result, total);
+            results[i] = result;
+        }
+    };
     
-    // For simplicity, process files sequentially
-    // Multi-threading would require connection pooling for database
-    for (const auto& file : files) {
-        ProcessingResult result = processFile(file);
-        results.push_back(result);
-        
-        ++processedCount_;
-        if (result.success) {
-            ++successCount_;
-            totalFeatures_ += result.featureCount;
-        } else {
-            ++failCount_;
-            if (verbose_) {
-                std::cerr << "Failed: " << result.fileName 
+    std::vector<std::thread> threads;
+    for (int w = 1; w < threadCount; ++w) {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    return results;
+}
+
+std::vector<ProcessingResult> ChartIngest::processQueue(CellQueue& queue, bool keepResults) {
+    std::vector<ProcessingResult> results;
+    resetStatistics();
+    
+    // Same as processFiles, but the total keeps growing while discovery runs
+    int threadCount = std::max(1, workerCount_);
+    std::atomic<int> sinkFailures{0};
+    auto worker = [&](int workerIndex) {
+        std::unique_ptr<ChartSink> sink = sinkFactory_();
+        if (!sink) {
+            std::cerr << "Worker " << workerIndex << ": failed to open output" << std::endl;
+            if (++sinkFailures < threadCount) return;
+            outputFailed_ = true;
+            while (auto cell = queue.pop()) {
+                queue.done(*cell);
+                ProcessingResult result;
+                result.fileName = fs::path(cell->path).filename().string();
+                result.errorMessage = "Failed to open output";
+                
+                std::lock_guard<std::mutex> lock(progressMutex_);
+                finishFile(result, static_cast<int>(queue.pushed()));
+                if (keepResults) {
+                    results.push_back(std::move(result));
+                }
+            }
+            return;
+        }
+        
+        while (auto cell = queue.pop()) {
+            ProcessingResult result = processFile(*cell, *sink);
+            queue.done(*cell);
+            
+            std::lock_guard<std::mutex> lock(progressMutex_);
+            finishFile(result, static_cast<int>(queue.pushed()));
+            if (keepResults) {
+                results.push_back(std::move(result));
+            } else if (!result.success && !result.skipped && !verbose_) {
+                std::cerr << "Failed: " << result.fileName
                           << " - " << result.errorMessage << std::endl;
             }
         }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int w = 1; w < threadCount; ++w) {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    return results;
+}
+
+std::vector<ProcessingResult> ChartIngest::processWorkQueue(WorkQueue& queue) {
+    std::vector<ProcessingResult> results;
+    resetStatistics();
+    
+    // The queue is shared with other processes, so there is no total.
+    // A worker without output claims nothing and leaves its share to the
+    // others, here or on other hosts
+    int threadCount = std::max(1, workerCount_);
+    std::atomic<int> sinkFailures{0};
+    auto worker = [&](int workerIndex) {
+        std::unique_ptr<ChartSink> sink = sinkFactory_();
+        if (!sink) {
+            std::cerr << "Worker " << workerIndex << ": failed to open output" << std::endl;
+            if (++sinkFailures == threadCount) outputFailed_ = true;
+            return;
+        }
         
-        if (progressCallback_) {
-            progressCallback_(processedCount_, total, result.fileName);
+        while (auto item = queue.claim()) {
+            CellFile cell;
+            cell.path = item->path;
+            ProcessingResult result = processFile(cell, *sink);
+            queue.finish(*item, result);
+            
+            std::lock_guard<std::mutex> lock(progressMutex_);
+            finishFile(result, 0);
+            results.push_back(std::move(result));
         }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int w = 1; w < threadCount; ++w) {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
     }
     
     return results;
 }
 
 std::vector<ProcessingResult> ChartIngest::processDirectory(const std::string& dirPath, bool recursive) {
-    auto files = findS57Files(dirPath, recursive);
+    // Catalogues and archives list everything in one read; only a plain
+    // tree walk is worth overlapping with processing
+    if (isArchivePath(dirPath) || !fs::is_directory(dirPath) ||
+        !findExchangeSetCatalog(dirPath).empty()) {
+        auto cells = findCells(dirPath, recursive);
+        
+        if (verbose_) {
+            std::cout << "Found " << cells.size() << " S-57 files" << std::endl;
+        }
+        
+        return processCells(cells);
+    }
+    
+    CellQueue queue;
+    DirectoryCrawler crawler(dirPath, recursive, CRAWLER_THREADS);
+    crawler.start(queue);
+    auto results = processQueue(queue);
+    crawler.join();
     
     if (verbose_) {
-        std::cout << "Found " << files.size() << " S-57 files" << std::endl;
+        std::cout << "Found " << queue.pushed() << " S-57 files" << std::endl;
+    }
+    
+    return results;
+}
+
+void ChartIngest::resetStatistics() {
+    processedCount_ = 0;
+    successCount_ = 0;
+    failCount_ = 0;
+    skippedCount_ = 0;
+    totalFeatures_ = 0;
+    outputFailed_ = false;
+}
+
+void ChartIngest::finishFile(const ProcessingResult& result, int total) {
+    ++processedCount_;
+    if (result.skipped) {
+        ++skippedCount_;
+    } else if (result.success) {
+        ++successCount_;
+        totalFeatures_ += result.featureCount;
+    } else {
+        ++failCount_;
+        if (verbose_) {
+            std::cerr << "Failed: " << result.fileName 
+                      << " - " << result.errorMessage << std::endl;
+        }
     }
     
-    return processFiles(files);
+    if (progressCallback_) {
+        progressCallback_(processedCount_, total, result.fileName);
+    }
 }
 
 ChartIngest::Statistics ChartIngest::getStatistics() const {
@@ -202,7 +517,9 @@ ChartIngest::Statistics ChartIngest::getStatistics() const {
     stats.totalFiles = processedCount_;
     stats.successCount = successCount_;
     stats.failCount = failCount_;
+    stats.skippedCount = skippedCount_;
     stats.totalFeatures = totalFeatures_;
+    stats.outputFailed = outputFailed_;
     return stats;
 }
 
@@ -9,10 +9,16 @@
 
 #include "types.hpp"
 #include "database.hpp"
+#include "sink.hpp"
+#include "crawler.hpp"
+#include "journal.hpp"
+#include "work_queue.hpp"
+#include "memory_budget.hpp"
 #include <string>
 #include <vector>
 #include <functional>
 #include <atomic>
+#include <mutex>
 
 namespace s57 {
 
@@ -23,7 +29,10 @@ using ProgressCallback = std::function<void(int current, int total, const std::s
 // Port of Njord's ChartIngest.kt
 class ChartIngest {
 public:
-    // Constructor
+    // Constructor - each worker writes through a sink from the factory
+    explicit ChartIngest(SinkFactory sinkFactory);
+
+    // Constructor - each worker opens its own connection like database's
     explicit ChartIngest(Database& database);
 
     // Set the number of worker threads
@@ -35,16 +44,47 @@ public:
     // Set verbose mode
     void setVerbose(bool verbose);
 
+    // Set the encode stage options applied by the workers
+    void setEncodeOptions(const EncodeOptions& options);
+
+    // Record committed charts in a journal and skip those it already has
+    // with the same content hash (nullptr disables)
+    void setJournal(IngestJournal* journal);
+
+    // Hold parsed charts and their encode buffers within a shared memory
+    // budget; workers wait for room before opening a chart (nullptr disables)
+    void setMemoryBudget(MemoryBudget* budget);
+
     // Find all .000 files in a directory
     static std::vector<std::string> findS57Files(const std::string& path, bool recursive);
 
+    // Find all base cells with their updates and sizes. A directory holding
+    // an exchange set (CATALOG.031, directly or in ENC_ROOT) is read from
+    // its catalogue; otherwise the directory is walked.
+    static std::vector<CellFile> findCells(const std::string& path, bool recursive);
+
     // Process a single file
     ProcessingResult processFile(const std::string& filePath);
 
-    // Process multiple files
+    // Process multiple files using the configured number of workers
     std::vector<ProcessingResult> processFiles(const std::vector<std::string>& files);
 
-    // Process a directory
+    // Same for cells from findCells, whose sizes size the memory budget
+    // reservations without another stat() per file
+    std::vector<ProcessingResult> processCells(const std::vector<CellFile>& cells);
+
+    // Process cells from a queue until it is closed and drained; results
+    // are in completion order. Without keepResults (a long-running watch)
+    // nothing is collected and failures are reported as they happen.
+    std::vector<ProcessingResult> processQueue(CellQueue& queue, bool keepResults = true);
+
+    // Claim cells from a shared queue until it is drained; each result is
+    // written back to the queue, and returned in completion order
+    std::vector<ProcessingResult> processWorkQueue(WorkQueue& queue);
+
+    // Process a directory. A plain directory tree is crawled in parallel
+    // while the workers already process the cells found so far; exchange
+    // sets and archives are listed up front.
     std::vector<ProcessingResult> processDirectory(const std::string& dirPath, bool recursive);
 
     // Get processing statistics
@@ -52,21 +92,39 @@ public:
         int totalFiles = 0;
         int successCount = 0;
         int failCount = 0;
+        int skippedCount = 0;
         int totalFeatures = 0;
+        bool outputFailed = false;  // No worker could open its output
     };
 
     Statistics getStatistics() const;
 
 private:
-    Database& database_;
+    SinkFactory sinkFactory_;
     int workerCount_ = 4;
     bool verbose_ = false;
+    EncodeOptions encodeOptions_;
+    IngestJournal* journal_ = nullptr;
+    MemoryBudget* memoryBudget_ = nullptr;
     ProgressCallback progressCallback_;
     
     std::atomic<int> processedCount_{0};
     std::atomic<int> successCount_{0};
     std::atomic<int> failCount_{0};
+    std::atomic<int> skippedCount_{0};
     std::atomic<int> totalFeatures_{0};
+    std::atomic<bool> outputFailed_{false};
+    std::mutex progressMutex_;
+
+    // Process a single cell into the given sink; a cell without a size is
+    // measured when the memory budget needs one
+    ProcessingResult processFile(const CellFile& cell, ChartSink& sink);
+
+    // Reset the counters before a run
+    void resetStatistics();
+
+    // Count a finished file and report progress (caller holds progressMutex_)
+    void finishFile(const ProcessingResult& result, int total);
 };
 
 } // namespace s57
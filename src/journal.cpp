@@ -0,0 +1,153 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Ingest checkpoint journal implementation
+
+#include "journal.hpp"
+#include "exchange_set.hpp"
+
+#include <cpl_vsi.h>
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace s57 {
+
+namespace {
+    constexpr const char* JOURNAL_HEADER = "# s57-postgis journal v1";
+    constexpr const char* TARGET_PREFIX = "# target ";
+
+    // 64-bit FNV-1a
+    constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    void hashBytes(uint64_t& hash, const unsigned char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= FNV_PRIME;
+        }
+    }
+
+    void hashString(uint64_t& hash, const std::string& value) {
+        hashBytes(hash, reinterpret_cast<const unsigned char*>(value.data()), value.size() + 1);
+    }
+
+    // Hash a whole file; false if it can't be opened
+    bool hashFile(uint64_t& hash, const std::string& path) {
+        VSILFILE* file = VSIFOpenL(path.c_str(), "rb");
+        if (!file) return false;
+
+        unsigned char buffer[65536];
+        size_t count;
+        while ((count = VSIFReadL(buffer, 1, sizeof(buffer), file)) > 0) {
+            hashBytes(hash, buffer, count);
+        }
+        VSIFCloseL(file);
+        return true;
+    }
+}
+
+IngestJournal::IngestJournal(std::string path, const std::string& target) : path_(std::move(path)) {
+    // Only a hash, so connection passwords don't end up in the file
+    uint64_t hash = FNV_OFFSET;
+    hashString(hash, target);
+    std::ostringstream line;
+    line << TARGET_PREFIX << std::hex << std::setw(16) << std::setfill('0') << hash;
+    targetLine_ = line.str();
+}
+
+bool IngestJournal::open(bool resume) {
+    if (resume) {
+        std::ifstream in(path_, std::ios::binary);
+        std::string line;
+        bool endsWithNewline = true;
+        std::string target;
+        while (std::getline(in, line)) {
+            endsWithNewline = !in.eof();
+            if (line.rfind(TARGET_PREFIX, 0) == 0) {
+                target = line;
+                continue;
+            }
+            if (line.empty() || line[0] == '#') continue;
+
+            // A line cut short by a kill doesn't parse and is ignored
+            size_t firstTab = line.find('\t');
+            size_t secondTab = firstTab == std::string::npos ? firstTab : line.find('\t', firstTab + 1);
+            if (secondTab == std::string::npos || !endsWithNewline) continue;
+
+            try {
+                uint64_t hash = std::stoull(line.substr(0, firstTab), nullptr, 16);
+                done_[line.substr(secondTab + 1)] = hash;
+            } catch (const std::exception&) {
+                continue;
+            }
+        }
+        loadedCount_ = done_.size();
+
+        // Entries say "committed to that database"; they mean nothing for another
+        if (!target.empty() && target != targetLine_) {
+            std::cerr << "Journal " << path_ << " was written for another database" << std::endl;
+            return false;
+        }
+
+        out_.open(path_, std::ios::app | std::ios::binary);
+        if (out_ && !endsWithNewline) {
+            out_ << '\n';
+        }
+    } else {
+        out_.open(path_, std::ios::trunc | std::ios::binary);
+    }
+
+    if (!out_) {
+        std::cerr << "Failed to open journal " << path_ << std::endl;
+        return false;
+    }
+    if (!resume || loadedCount_ == 0) {
+        out_ << JOURNAL_HEADER << '\n' << targetLine_ << '\n' << std::flush;
+    }
+    return true;
+}
+
+bool IngestJournal::isOpen() const {
+    return out_.is_open();
+}
+
+size_t IngestJournal::loadedCount() const {
+    return loadedCount_;
+}
+
+bool IngestJournal::isDone(const std::string& filePath, uint64_t hash) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = done_.find(filePath);
+    return it != done_.end() && it->second == hash;
+}
+
+bool IngestJournal::record(const std::string& filePath, uint64_t hash, const std::string& chartName) {
+    std::ostringstream line;
+    line << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec
+         << '\t' << chartName << '\t' << filePath << '\n';
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_[filePath] = hash;
+    out_ << line.str() << std::flush;
+    return static_cast<bool>(out_);
+}
+
+uint64_t IngestJournal::contentHash(const std::string& filePath, const EncodeOptions& options) {
+    uint64_t hash = FNV_OFFSET;
+
+    std::ostringstream encode;
+    encode << options.generalize << options.quantize << ' ' << options.precision << ' '
+           << options.subdivideVertices << ' ' << options.compactSoundings << options.spatialOrder;
+    hashString(hash, encode.str());
+
+    if (!hashFile(hash, filePath)) return 0;
+
+    for (const auto& update : findCellUpdates(filePath)) {
+        if (!hashFile(hash, update)) return 0;
+    }
+    return hash;
+}
+
+} // namespace s57
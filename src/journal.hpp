@@ -0,0 +1,71 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Ingest checkpoint journal header
+
+#ifndef S57_POSTGIS_JOURNAL_HPP
+#define S57_POSTGIS_JOURNAL_HPP
+
+#include "types.hpp"
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+namespace s57 {
+
+// IngestJournal records each chart once its transaction has committed,
+// with a hash of its content, so a killed run can be resumed and skip the
+// charts that are already in the database. Entries are appended and
+// flushed one line at a time:
+//
+//   <hash>\t<chart name>\t<file path>
+//
+// The header names the database the entries were committed to (as a hash
+// of its connection string); resuming against another database is refused.
+//
+// A chart that was committed but not yet journaled when the run died is
+// simply ingested again; beginChart replaces it by name.
+class IngestJournal {
+public:
+    // target identifies the output the charts are committed to
+    IngestJournal(std::string path, const std::string& target);
+
+    // Prevent copying
+    IngestJournal(const IngestJournal&) = delete;
+    IngestJournal& operator=(const IngestJournal&) = delete;
+
+    // Open the journal: with resume, load the previous run's entries and
+    // append to it; otherwise start an empty journal
+    bool open(bool resume);
+
+    // Check if the journal was opened successfully
+    bool isOpen() const;
+
+    // Number of entries loaded from a previous run
+    size_t loadedCount() const;
+
+    // Check if a file was committed with this content hash
+    bool isDone(const std::string& filePath, uint64_t hash) const;
+
+    // Record a committed chart (thread-safe)
+    bool record(const std::string& filePath, uint64_t hash, const std::string& chartName);
+
+    // Hash of a cell's content as GDAL will read it: the base cell, its
+    // updates (found like GDAL does, see findCellUpdates) and the encode
+    // options, which change what gets stored
+    static uint64_t contentHash(const std::string& filePath, const EncodeOptions& options);
+
+private:
+    std::string path_;
+    std::string targetLine_;
+    std::ofstream out_;
+    std::unordered_map<std::string, uint64_t> done_;
+    size_t loadedCount_ = 0;
+    mutable std::mutex mutex_;
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_JOURNAL_HPP
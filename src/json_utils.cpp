@@ -46,6 +46,58 @@ std::string toJsonObject(const std::map<std::string, std::string>& props) {
     return ss.str();
 }
 
+namespace {
+    // Read a JSON string starting at the opening quote; pos ends past the closing quote
+    bool readString(const std::string& json, size_t& pos, std::string& out) {
+        if (pos >= json.size() || json[pos] != '"') return false;
+        ++pos;
+        out.clear();
+        while (pos < json.size()) {
+            char c = json[pos++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= json.size()) return false;
+            char e = json[pos++];
+            switch (e) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    // toJsonObject only escapes control characters this way
+                    if (pos + 4 > json.size()) return false;
+                    out += static_cast<char>(std::stoi(json.substr(pos, 4), nullptr, 16));
+                    pos += 4;
+                    break;
+                }
+                default: out += e;
+            }
+        }
+        return false;
+    }
+}
+
+std::map<std::string, std::string> fromJsonObject(const std::string& json) {
+    std::map<std::string, std::string> props;
+    size_t pos = 0;
+    if (json.empty() || json[pos++] != '{') return props;
+
+    std::string key;
+    std::string value;
+    while (pos < json.size() && json[pos] != '}') {
+        if (!readString(json, pos, key)) return {};
+        if (pos >= json.size() || json[pos++] != ':') return {};
+        if (!readString(json, pos, value)) return {};
+        props[key] = value;
+        if (pos < json.size() && json[pos] == ',') ++pos;
+    }
+    return props;
+}
+
 std::string toJsonArray(const std::vector<std::string>& items) {
     std::ostringstream ss;
     ss << "[";
@@ -20,6 +20,10 @@ std::string escapeString(const std::string& str);
 // Convert a map of key-value pairs to a JSON object string
 std::string toJsonObject(const std::map<std::string, std::string>& props);
 
+// Parse a flat JSON object of string values, as written by toJsonObject
+// Returns an empty map for anything else
+std::map<std::string, std::string> fromJsonObject(const std::string& json);
+
 // Create a JSON array from a vector of strings
 std::string toJsonArray(const std::vector<std::string>& items);
 
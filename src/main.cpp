@@ -5,45 +5,141 @@
 // S57-PostGIS - C++ port of Njord's S-57 chart processing
 
 #include "types.hpp"
+#include "geometry.hpp"
 #include "s57.hpp"
 #include "database.hpp"
 #include "ingest.hpp"
+#include "dump.hpp"
+#include "export.hpp"
+#include "tiles.hpp"
+#include "sink.hpp"
+#include "catalog.hpp"
+#include "report.hpp"
+#include "exchange_set.hpp"
+#include "journal.hpp"
+#include "watcher.hpp"
+#include "shard.hpp"
 
 #include <iostream>
 #include <string>
 #include <vector>
+#include <set>
+#include <algorithm>
 #include <cstring>
+#include <cstdio>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
 // Program version
 const char* VERSION = "1.0.0";
 
+// Set by SIGINT/SIGTERM to end --watch
+std::atomic<bool> stopRequested{false};
+
+void onStopSignal(int) {
+    stopRequested = true;
+}
+
 // Print usage information
 void printUsage(const char* progName) {
     std::cout << "S57-PostGIS v" << VERSION << "\n"
               << "C++ port of Njord's S-57 chart processing system\n\n"
               << "Usage: " << progName << " <input> [options]\n\n"
               << "Input:\n"
-              << "  <input>                 S-57 file (.000) or directory\n\n"
+              << "  <input>                 S-57 file (.000), directory, or zip/tar\n"
+              << "                          archive (read in place, not unpacked)\n\n"
               << "Database Options:\n"
               << "  -d, --database <conn>   PostgreSQL connection string\n"
               << "                          Default: postgresql://localhost/njord\n"
-              << "  --init-schema           Initialize database schema\n\n"
+              << "  --init-schema           Initialize database schema\n"
+              << "  --bulk-load             Load without secondary indexes, then build\n"
+              << "                          them in parallel and ANALYZE (initial loads)\n"
+              << "  --unlogged              With --bulk-load, load into UNLOGGED tables\n"
+              << "  --quilt                 After ingest, update chart_quilt for the\n"
+              << "                          charts whose coverage changed (also --dump)\n"
+              << "  --quilt-rebuild         Recompute chart_quilt for all charts\n"
+              << "                          (runs without <input>)\n\n"
+              << "Dump Options (no database required):\n"
+              << "  --dump <dir>            Write a COPY dump loadable with psql instead\n"
+              << "                          of connecting to a database\n"
+              << "  --dump-compress         gzip the dump parts\n"
+              << "  --dump-split <rows>     Start a new part every <rows> rows\n\n"
+              << "Export Options (no database required):\n"
+              << "  --export <path>         Write charts/features to a GeoPackage (.gpkg)\n"
+              << "                          or a new FlatGeobuf directory (any other\n"
+              << "                          path); a chart name is exported once\n\n"
+              << "Tile Options (no database required):\n"
+              << "  --tiles <path>          Pre-generate vector tiles into .mbtiles,\n"
+              << "                          .pmtiles or a {z}/{x}/{y}.pbf directory\n"
+              << "  --tile-min-zoom <z>     Lowest zoom generated (default: 0)\n"
+              << "  --tile-max-zoom <z>     Highest zoom generated (default: 16)\n\n"
               << "Processing Options:\n"
               << "  -w, --workers <n>       Number of parallel workers (default: 4)\n"
               << "  -r, --recursive         Recursively search directories\n"
-              << "  -v, --verbose           Verbose output\n\n"
+              << "  --staging               COPY charts into per-worker staging tables\n"
+              << "                          and merge them in a single transaction\n"
+              << "  --max-memory <size>     Cap memory held by parsed charts across\n"
+              << "                          workers, e.g. 2G (workers wait for room; a\n"
+              << "                          chart bigger than estimated can overshoot)\n"
+              << "  -v, --verbose           Verbose output\n"
+              << "  --generalize            Store simplified geometry per zoom band\n"
+              << "                          below the chart zoom (feature_lods)\n"
+              << "  --quantize              Snap coordinates to the chart's COMF grid,\n"
+              << "                          drop duplicate vertices, compact GeoJSON\n"
+              << "  --precision <digits>    Quantize to a number of decimal places\n"
+              << "                          instead of the COMF grid (implies --quantize)\n"
+              << "  --subdivide <n>         Also store areas above n vertices as pieces\n"
+              << "                          of at most n vertices (feature_parts)\n"
+              << "  --compact-soundings     Store SOUNDG in the soundings table (point,\n"
+              << "                          depth, shared attributes) instead of features\n"
+              << "  --spatial-order         Write each chart's features in Hilbert order\n"
+              << "                          of their bbox (heap locality without CLUSTER)\n"
+              << "  --journal <file>        Record committed charts with a content hash\n"
+              << "  --resume                Skip charts the journal already has unchanged\n"
+              << "                          (default journal: s57-postgis.journal; database\n"
+              << "                          ingest only, tied to the -d database)\n"
+              << "  --watch                 Keep running and ingest cells as they arrive\n"
+              << "                          or get updates (inotify; Ctrl-C to stop;\n"
+              << "                          no --quilt, run --quilt-rebuild separately)\n"
+              << "  --debounce <ms>         Wait for a cell's files to settle (default: 2000)\n"
+              << "  --shard <i>/<N>         Ingest only shard i of N (one per host)\n"
+              << "  --shard-by <strategy>   name (default, hash of the cell name) or\n"
+              << "                          size (balance bytes; hosts need the same list)\n"
+              << "  --run-id <id>           Name of the sharded run (default: default)\n"
+              << "  --shard-summary         Merge the shard results of --run-id (runs\n"
+              << "                          without <input>; with --quilt, update the\n"
+              << "                          quilt once every shard has finished)\n"
+              << "  --queue <name>          Share the cells of <input> through the\n"
+              << "                          ingest_queue table with other processes\n"
+              << "                          (join as a worker when <input> is omitted)\n"
+              << "  --lease <seconds>       Requeue cells of a worker silent this long\n"
+              << "                          (default: 60)\n"
+              << "  --queue-status          Show the progress of --queue (with --quilt,\n"
+              << "                          update the quilt once it is drained)\n"
+              << "  --null-sink             Parse only and discard the output\n"
+              << "                          (measures parse throughput)\n\n"
               << "Other Options:\n"
-              << "  --list                  List all .000 files found\n"
-              << "  --info                  Show chart metadata (for single file)\n"
+              << "  --list                  List all .000 files found (with update count\n"
+              << "                          and total size)\n"
+              << "  --info                  Show chart metadata; for a directory, write\n"
+              << "                          a one-line-per-chart report (parallel)\n"
+              << "  --info-format <fmt>     Report format: csv (default) or json lines\n"
+              << "  --covering <lon>,<lat>  List charts covering a point, best scale\n"
+              << "                          first (scans <input>, else the database)\n"
               << "  -h, --help              Show this help\n"
               << "  --version               Show version\n\n"
               << "Examples:\n"
               << "  " << progName << " chart.000 -d postgresql://localhost/njord\n"
               << "  " << progName << " /charts -r -v\n"
               << "  " << progName << " /charts --list\n"
+              << "  " << progName << " /charts -r --shard 2/4 --run-id weekly\n"
               << std::endl;
 }
 
@@ -82,21 +178,213 @@ void showChartInfo(const std::string& filePath) {
               << std::endl;
 }
 
+// List charts whose coverage contains a point
+int showCovering(const std::string& point, const std::string& inputPath,
+                 const s57::ProcessingOptions& opts) {
+    double lon = 0, lat = 0;
+    if (std::sscanf(point.c_str(), "%lf,%lf", &lon, &lat) != 2) {
+        std::cerr << "Error: --covering expects <lon>,<lat>" << std::endl;
+        return 1;
+    }
+
+    s57::ChartCatalog catalog;
+    if (!inputPath.empty()) {
+        auto files = s57::ChartIngest::findS57Files(inputPath, opts.recursive);
+        catalog.loadFromFiles(files, opts.workers);
+    } else {
+        s57::Database db(opts.databaseUrl);
+        if (!catalog.loadFromDatabase(db)) {
+            std::cerr << "Error: Failed to connect to database" << std::endl;
+            return 1;
+        }
+    }
+
+    auto charts = catalog.covering(lon, lat);
+    for (const auto* entry : charts) {
+        std::cout << entry->info.name << "  1:" << entry->info.scale
+                  << "  z" << entry->info.zoom;
+        if (!entry->filePath.empty()) {
+            std::cout << "  " << entry->filePath;
+        }
+        std::cout << "\n";
+    }
+    std::cout << "\n" << charts.size() << " of " << catalog.size()
+              << " charts cover " << lon << "," << lat << std::endl;
+    return 0;
+}
+
+// Host name recorded with a shard's result
+std::string hostName() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0) return "unknown";
+    return name;
+}
+
+// Merge and print the shard results of a run (--shard-summary)
+int showShardSummary(const s57::ProcessingOptions& opts) {
+    s57::Database db(opts.databaseUrl);
+    if (!db.isConnected()) {
+        std::cerr << "Error: Failed to connect to database" << std::endl;
+        return 1;
+    }
+
+    auto summaries = db.getIngestSummaries(opts.runId);
+    if (summaries.empty()) {
+        std::cerr << "Error: No shard results for run " << opts.runId << std::endl;
+        return 1;
+    }
+
+    // Shard i/N and i/M cover different cells, so their totals can't add up
+    std::set<int> shardCounts;
+    for (const auto& summary : summaries) {
+        shardCounts.insert(summary.shardCount);
+    }
+    if (shardCounts.size() > 1) {
+        std::cerr << "Error: Run " << opts.runId << " mixes shard counts";
+        for (int count : shardCounts) {
+            std::cerr << " " << count;
+        }
+        std::cerr << "; rerun the shards under a new --run-id" << std::endl;
+        return 1;
+    }
+
+    int shardCount = 0;
+    s57::IngestSummary total;
+    std::vector<bool> finished;
+    std::cout << "Run " << opts.runId << ":\n";
+    for (const auto& summary : summaries) {
+        shardCount = std::max(shardCount, summary.shardCount);
+        if (finished.size() < static_cast<size_t>(shardCount)) {
+            finished.resize(static_cast<size_t>(shardCount), false);
+        }
+        finished[static_cast<size_t>(summary.shard - 1)] = true;
+
+        std::cout << "  Shard " << summary.shard << "/" << summary.shardCount
+                  << "  " << summary.host << "  " << summary.finishedAt
+                  << "  " << summary.succeeded << " ok, " << summary.failed << " failed, "
+                  << summary.skipped << " skipped, " << summary.features << " features\n";
+        total.files += summary.files;
+        total.succeeded += summary.succeeded;
+        total.failed += summary.failed;
+        total.skipped += summary.skipped;
+        total.features += summary.features;
+        total.failures.insert(total.failures.end(), summary.failures.begin(), summary.failures.end());
+    }
+
+    std::vector<int> missing;
+    for (size_t i = 0; i < finished.size(); ++i) {
+        if (!finished[i]) missing.push_back(static_cast<int>(i) + 1);
+    }
+
+    std::cout << "\nProcessing Complete:\n"
+              << "  Shards:          " << (shardCount - static_cast<int>(missing.size()))
+              << "/" << shardCount << "\n"
+              << "  Files processed: " << total.files << "\n"
+              << "  Successful:      " << total.succeeded << "\n"
+              << "  Failed:          " << total.failed << "\n"
+              << "  Skipped:         " << total.skipped << "\n"
+              << "  Total features:  " << total.features << "\n";
+
+    if (!total.failures.empty()) {
+        std::cout << "\nFailed files:\n";
+        for (const auto& failure : total.failures) {
+            std::cout << "  " << failure << "\n";
+        }
+    }
+
+    if (!missing.empty()) {
+        std::cout << "\nMissing shards:";
+        for (int shard : missing) {
+            std::cout << " " << shard;
+        }
+        std::cout << std::endl;
+        return 1;
+    }
+
+    // The quilt is left to this step so hosts don't recompute it concurrently
+    if (opts.quilt || opts.quiltRebuild) {
+        std::cout << "Updating chart quilt..." << std::endl;
+        if (!db.updateQuilt(opts.quiltRebuild)) {
+            std::cerr << "Error: Failed to update chart quilt" << std::endl;
+            return 1;
+        }
+    }
+    return total.failed > 0 ? 1 : 0;
+}
+
+// Show the progress of a shared ingest queue (--queue-status)
+int showQueueStatus(const s57::ProcessingOptions& opts) {
+    if (opts.queueName.empty()) {
+        std::cerr << "Error: --queue-status requires --queue <name>" << std::endl;
+        return 1;
+    }
+    s57::Database db(opts.databaseUrl);
+    if (!db.isConnected()) {
+        std::cerr << "Error: Failed to connect to database" << std::endl;
+        return 1;
+    }
+
+    auto counts = db.getQueueCounts(opts.queueName);
+    if (counts.empty()) {
+        std::cerr << "Error: Queue " << opts.queueName << " is empty" << std::endl;
+        return 1;
+    }
+
+    int open = 0;
+    int failed = 0;
+    std::cout << "Queue " << opts.queueName << ":\n";
+    for (const auto& [status, count] : counts) {
+        std::cout << "  " << status << ": " << count << "\n";
+        if (status == "pending" || status == "running") open += count;
+        if (status == "failed") failed += count;
+    }
+
+    if (failed > 0) {
+        std::cout << "\nFailed files:\n";
+        for (const auto& [path, error] : db.getQueueFailures(opts.queueName)) {
+            std::cout << "  " << path << ": " << error << "\n";
+        }
+    }
+
+    if (open > 0) {
+        std::cout << "\n" << open << " cells still open" << std::endl;
+        return 1;
+    }
+
+    // As with --shard-summary, the quilt is updated once for all workers
+    if (opts.quilt || opts.quiltRebuild) {
+        std::cout << "Updating chart quilt..." << std::endl;
+        if (!db.updateQuilt(opts.quiltRebuild)) {
+            std::cerr << "Error: Failed to update chart quilt" << std::endl;
+            return 1;
+        }
+    }
+    return failed > 0 ? 1 : 0;
+}
+
 // List files
 void listFiles(const std::string& path, bool recursive) {
-    auto files = s57::ChartIngest::findS57Files(path, recursive);
+    auto cells = s57::ChartIngest::findCells(path, recursive);
     
-    std::cout << "Found " << files.size() << " S-57 files:\n";
-    for (const auto& file : files) {
-        std::cout << "  " << file << "\n";
+    uintmax_t totalSize = 0;
+    std::cout << "Found " << cells.size() << " S-57 files:\n";
+    for (const auto& cell : cells) {
+        std::cout << "  " << cell.path;
+        if (!cell.updates.empty()) {
+            std::cout << " (+" << cell.updates.size() << " updates)";
+        }
+        std::cout << "\n";
+        totalSize += cell.size;
     }
-    std::cout << std::endl;
+    std::cout << "Total size: " << totalSize / (1024 * 1024) << " MB" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
     // Default options
     s57::ProcessingOptions opts;
     std::string inputPath;
+    std::string coveringPoint;
+    std::string infoFormat;
     
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
@@ -144,10 +432,231 @@ int main(int argc, char* argv[]) {
             opts.infoOnly = true;
             continue;
         }
+        if (arg == "--info-format") {
+            if (i + 1 < argc) {
+                infoFormat = argv[++i];
+                opts.infoOnly = true;
+            } else {
+                std::cerr << "Error: --info-format requires csv or json\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--covering") {
+            if (i + 1 < argc) {
+                coveringPoint = argv[++i];
+            } else {
+                std::cerr << "Error: --covering requires <lon>,<lat>\n";
+                return 1;
+            }
+            continue;
+        }
         if (arg == "--init-schema") {
             opts.initSchema = true;
             continue;
         }
+        if (arg == "--tiles") {
+            if (i + 1 < argc) {
+                opts.tilesPath = argv[++i];
+            } else {
+                std::cerr << "Error: --tiles requires a path\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--tile-min-zoom" || arg == "--tile-max-zoom") {
+            if (i + 1 < argc) {
+                int zoom = std::stoi(argv[++i]);
+                (arg == "--tile-min-zoom" ? opts.tileMinZoom : opts.tileMaxZoom) = zoom;
+            } else {
+                std::cerr << "Error: " << arg << " requires a number\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--export") {
+            if (i + 1 < argc) {
+                opts.exportPath = argv[++i];
+            } else {
+                std::cerr << "Error: --export requires a path\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--dump") {
+            if (i + 1 < argc) {
+                opts.dumpDir = argv[++i];
+            } else {
+                std::cerr << "Error: --dump requires a directory\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--dump-compress") {
+            opts.dumpCompress = true;
+            continue;
+        }
+        if (arg == "--dump-split") {
+            if (i + 1 < argc) {
+                opts.dumpRowsPerFile = std::stoul(argv[++i]);
+            } else {
+                std::cerr << "Error: --dump-split requires a number\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--generalize") {
+            opts.encode.generalize = true;
+            continue;
+        }
+        if (arg == "--quantize") {
+            opts.encode.quantize = true;
+            continue;
+        }
+        if (arg == "--precision") {
+            if (i + 1 < argc) {
+                opts.encode.precision = std::stoi(argv[++i]);
+                opts.encode.quantize = true;
+            } else {
+                std::cerr << "Error: --precision requires a number\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--subdivide") {
+            if (i + 1 < argc) {
+                opts.encode.subdivideVertices = std::stoi(argv[++i]);
+                if (opts.encode.subdivideVertices < s57::geometry::SUBDIVIDE_MIN_VERTICES) {
+                    std::cerr << "Error: --subdivide needs at least "
+                              << s57::geometry::SUBDIVIDE_MIN_VERTICES << " vertices\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --subdivide requires a vertex count\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--compact-soundings") {
+            opts.encode.compactSoundings = true;
+            continue;
+        }
+        if (arg == "--spatial-order") {
+            opts.encode.spatialOrder = true;
+            continue;
+        }
+        if (arg == "--null-sink") {
+            opts.nullSink = true;
+            continue;
+        }
+        if (arg == "--staging") {
+            opts.staging = true;
+            continue;
+        }
+        if (arg == "--bulk-load") {
+            opts.bulkLoad = true;
+            continue;
+        }
+        if (arg == "--quilt") {
+            opts.quilt = true;
+            continue;
+        }
+        if (arg == "--quilt-rebuild") {
+            opts.quiltRebuild = true;
+            continue;
+        }
+        if (arg == "--journal") {
+            if (i + 1 < argc) {
+                opts.journalPath = argv[++i];
+            } else {
+                std::cerr << "Error: --journal requires a path\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--watch") {
+            opts.watch = true;
+            continue;
+        }
+        if (arg == "--debounce") {
+            if (i + 1 < argc) {
+                opts.watchDebounceMs = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "Error: --debounce requires milliseconds\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--shard") {
+            if (i + 1 < argc) {
+                opts.shard = argv[++i];
+            } else {
+                std::cerr << "Error: --shard requires <i>/<N>\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--shard-by") {
+            if (i + 1 < argc) {
+                opts.shardBy = argv[++i];
+            } else {
+                std::cerr << "Error: --shard-by requires a strategy\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--run-id") {
+            if (i + 1 < argc) {
+                opts.runId = argv[++i];
+            } else {
+                std::cerr << "Error: --run-id requires an id\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--shard-summary") {
+            opts.shardSummary = true;
+            continue;
+        }
+        if (arg == "--max-memory") {
+            if (i + 1 < argc && s57::parseByteSize(argv[i + 1], opts.maxMemory)) {
+                ++i;
+            } else {
+                std::cerr << "Error: --max-memory requires a size (e.g. 512M, 4G)\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--queue") {
+            if (i + 1 < argc) {
+                opts.queueName = argv[++i];
+            } else {
+                std::cerr << "Error: --queue requires a name\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--lease") {
+            if (i + 1 < argc) {
+                opts.queueLeaseSeconds = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "Error: --lease requires seconds\n";
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--queue-status") {
+            opts.queueStatus = true;
+            continue;
+        }
+        if (arg == "--resume") {
+            opts.resume = true;
+            continue;
+        }
+        if (arg == "--unlogged") {
+            opts.unlogged = true;
+            continue;
+        }
         
         // Input path
         if (inputPath.empty() && arg[0] != '-') {
@@ -171,10 +680,30 @@ int main(int argc, char* argv[]) {
             std::cerr << "Error: No input file specified\n";
             return 1;
         }
+        if (fs::is_directory(inputPath) || s57::isArchivePath(inputPath) || !infoFormat.empty()) {
+            s57::ReportOptions reportOpts;
+            reportOpts.workers = opts.workers;
+            if (!infoFormat.empty() && !s57::parseReportFormat(infoFormat, reportOpts.format)) {
+                std::cerr << "Error: Unknown --info-format: " << infoFormat << "\n";
+                return 1;
+            }
+            auto cells = s57::ChartIngest::findCells(inputPath, opts.recursive);
+            int failed = s57::writeChartReport(cells, reportOpts, std::cout);
+            if (failed > 0) {
+                std::cerr << "Warning: " << failed << " of " << cells.size()
+                          << " files could not be opened" << std::endl;
+            }
+            return 0;
+        }
         showChartInfo(inputPath);
         return 0;
     }
     
+    // Handle --covering
+    if (!coveringPoint.empty()) {
+        return showCovering(coveringPoint, inputPath, opts);
+    }
+    
     // Handle --init-schema only
     if (opts.initSchema && inputPath.empty()) {
         std::cout << "Initializing database schema..." << std::endl;
@@ -192,42 +721,215 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    // Validate input
-    if (inputPath.empty()) {
+    // Handle --shard-summary
+    if (opts.shardSummary) {
+        return showShardSummary(opts);
+    }
+    
+    // Handle --queue-status
+    if (opts.queueStatus) {
+        return showQueueStatus(opts);
+    }
+    
+    // Handle --quilt-rebuild only
+    if (opts.quiltRebuild && inputPath.empty()) {
+        std::cout << "Rebuilding chart quilt..." << std::endl;
+        s57::Database db(opts.databaseUrl);
+        if (!db.isConnected()) {
+            std::cerr << "Error: Failed to connect to database" << std::endl;
+            return 1;
+        }
+        if (!db.updateQuilt(true)) {
+            std::cerr << "Error: Failed to rebuild chart quilt" << std::endl;
+            return 1;
+        }
+        std::cout << "Chart quilt rebuilt." << std::endl;
+        return 0;
+    }
+    
+    // Validate input (queue workers may join without one)
+    if (inputPath.empty() && opts.queueName.empty()) {
         std::cerr << "Error: No input specified\n\n";
         printUsage(argv[0]);
         return 1;
     }
     
-    if (!fs::exists(inputPath)) {
+    bool archive = s57::isArchivePath(inputPath);
+    if (!inputPath.empty() && !archive && !fs::exists(inputPath)) {
         std::cerr << "Error: Input path does not exist: " << inputPath << std::endl;
         return 1;
     }
     
-    // Connect to database
-    if (opts.verbose) {
-        std::cout << "Connecting to database: " << opts.databaseUrl << std::endl;
+    // A dump can only carry the incremental quilt update; other outputs have none
+    if (opts.quiltRebuild && !opts.dumpDir.empty()) {
+        std::cerr << "Error: --quilt-rebuild needs a database; run it after loading the dump\n";
+        return 1;
+    }
+    if ((opts.quilt || opts.quiltRebuild) &&
+        (opts.nullSink || !opts.exportPath.empty() || !opts.tilesPath.empty())) {
+        std::cerr << "Error: --quilt/--quilt-rebuild need database or --dump output\n";
+        return 1;
     }
     
-    s57::Database db(opts.databaseUrl);
-    if (!db.isConnected()) {
-        std::cerr << "Error: Failed to connect to database" << std::endl;
+    // Journal entries mean "committed"; staged charts only commit at the
+    // merge, and file outputs are rewritten from scratch each run
+    bool fileOutput = !opts.dumpDir.empty() || !opts.exportPath.empty() || !opts.tilesPath.empty();
+    if (opts.watch && (opts.staging || opts.bulkLoad || fileOutput || !fs::is_directory(inputPath))) {
+        std::cerr << "Error: --watch needs a directory and direct database or --null-sink ingest\n";
+        return 1;
+    }
+    // Watch mode never finishes a batch the quilt could be updated after
+    if (opts.watch && (opts.quilt || opts.quiltRebuild)) {
+        std::cerr << "Error: --quilt/--quilt-rebuild can't be combined with --watch; "
+                  << "run --quilt-rebuild separately\n";
+        return 1;
+    }
+    s57::ShardSpec shard;
+    if (!opts.shard.empty()) {
+        if (!s57::parseShardSpec(opts.shard, shard) || !s57::parseShardStrategy(opts.shardBy, shard.strategy)) {
+            std::cerr << "Error: --shard expects <i>/<N> with 1 <= i <= N, --shard-by name or size\n";
+            return 1;
+        }
+        // Bulk load drops and rebuilds the shared indexes, which can't be
+        // split between hosts
+        if (opts.bulkLoad || opts.watch) {
+            std::cerr << "Error: --shard can't be combined with --bulk-load or --watch\n";
+            return 1;
+        }
+    }
+    // Queue rows are marked done once the chart is committed, and the quilt
+    // is left to --queue-status
+    if (!opts.queueName.empty() &&
+        (opts.staging || opts.bulkLoad || opts.nullSink || fileOutput || opts.watch ||
+         !opts.shard.empty() || !opts.journalPath.empty() || opts.resume || opts.quilt)) {
+        std::cerr << "Error: --queue needs direct database ingest without --staging, --bulk-load,\n"
+                  << "       --null-sink, --dump, --export, --tiles, --watch, --shard, --journal,\n"
+                  << "       --resume or --quilt (use --queue-status --quilt)\n";
         return 1;
     }
+    if (opts.resume && opts.journalPath.empty()) {
+        opts.journalPath = "s57-postgis.journal";
+    }
+    std::unique_ptr<s57::IngestJournal> journal;
+    if (!opts.journalPath.empty()) {
+        // A parse-only run commits nothing a later --resume could skip
+        if (opts.staging || opts.nullSink || fileOutput) {
+            std::cerr << "Error: --journal/--resume only work with direct database ingest\n";
+            return 1;
+        }
+        journal = std::make_unique<s57::IngestJournal>(opts.journalPath, opts.databaseUrl);
+        if (!journal->open(opts.resume)) {
+            return 1;
+        }
+        if (opts.resume) {
+            std::cout << "Resuming: " << journal->loadedCount() << " charts already in "
+                      << opts.journalPath << std::endl;
+        }
+    }
     
-    // Initialize schema if requested
-    if (opts.initSchema) {
-        std::cout << "Initializing database schema..." << std::endl;
-        if (!db.initSchema()) {
-            std::cerr << "Error: Failed to initialize schema" << std::endl;
+    // Dump and null outputs need no database; everything else does
+    std::unique_ptr<s57::Database> db;
+    std::unique_ptr<s57::CopyDump> dump;
+    std::unique_ptr<s57::VectorExport> vectorExport;
+    std::unique_ptr<s57::TileExport> tileExport;
+    s57::SinkFactory sinkFactory;
+    std::mutex stagingMutex;
+    std::vector<std::string> stagingSuffixes;
+    
+    if (opts.nullSink) {
+        sinkFactory = []() { return std::make_unique<s57::NullSink>(); };
+    } else if (!opts.tilesPath.empty()) {
+        s57::TileOptions tileOpts;
+        tileOpts.path = opts.tilesPath;
+        tileOpts.minZoom = opts.tileMinZoom;
+        tileOpts.maxZoom = opts.tileMaxZoom;
+        tileOpts.threads = opts.workers;
+        
+        tileExport = std::make_unique<s57::TileExport>(tileOpts);
+        if (!tileExport->isOpen()) {
+            std::cerr << "Error: Failed to create tiles " << opts.tilesPath << std::endl;
+            return 1;
+        }
+        sinkFactory = [&tileExport]() { return tileExport->openSink(); };
+    } else if (!opts.exportPath.empty()) {
+        vectorExport = std::make_unique<s57::VectorExport>(opts.exportPath);
+        if (!vectorExport->isOpen()) {
+            std::cerr << "Error: Failed to create export " << opts.exportPath << std::endl;
+            return 1;
+        }
+        if (opts.verbose) {
+            std::cout << "Exporting to " << opts.exportPath 
+                      << " (" << vectorExport->getDriverName() << ")" << std::endl;
+        }
+        sinkFactory = [&vectorExport]() { return vectorExport->openSink(); };
+    } else if (!opts.dumpDir.empty()) {
+        s57::DumpOptions dumpOpts;
+        dumpOpts.directory = opts.dumpDir;
+        dumpOpts.compress = opts.dumpCompress;
+        dumpOpts.rowsPerFile = opts.dumpRowsPerFile;
+        dumpOpts.quilt = opts.quilt;
+        
+        dump = std::make_unique<s57::CopyDump>(dumpOpts);
+        if (!dump->isOpen()) {
+            std::cerr << "Error: Failed to create dump in " << opts.dumpDir << std::endl;
+            return 1;
+        }
+        sinkFactory = [&dump]() { return dump->openSink(); };
+    } else {
+        // Connect to database
+        if (opts.verbose) {
+            std::cout << "Connecting to database: " << opts.databaseUrl << std::endl;
+        }
+        
+        db = std::make_unique<s57::Database>(opts.databaseUrl);
+        if (!db->isConnected()) {
+            std::cerr << "Error: Failed to connect to database" << std::endl;
             return 1;
         }
+        
+        // Initialize schema if requested
+        if (opts.initSchema) {
+            std::cout << "Initializing database schema..." << std::endl;
+            if (!db->initSchema()) {
+                std::cerr << "Error: Failed to initialize schema" << std::endl;
+                return 1;
+            }
+        }
+        
+        // Drop secondary indexes before loading; they are rebuilt at the end
+        if (opts.bulkLoad) {
+            std::cout << "Preparing bulk load..." << std::endl;
+            if (!db->beginBulkLoad(opts.unlogged)) {
+                std::cerr << "Error: Failed to prepare bulk load" << std::endl;
+                return 1;
+            }
+        }
+        
+        // One connection per worker; staging sessions are merged at the end
+        sinkFactory = [&]() -> std::unique_ptr<s57::ChartSink> {
+            auto workerDb = std::make_unique<s57::Database>(opts.databaseUrl);
+            if (!workerDb->isConnected()) return nullptr;
+            if (opts.staging) {
+                if (!workerDb->beginStaging()) return nullptr;
+                std::lock_guard<std::mutex> lock(stagingMutex);
+                stagingSuffixes.push_back(workerDb->getStagingSuffix());
+            }
+            return workerDb;
+        };
     }
     
     // Create ingest processor
-    s57::ChartIngest ingest(db);
+    s57::ChartIngest ingest(sinkFactory);
     ingest.setWorkerCount(opts.workers);
+    ingest.setJournal(journal.get());
+    
+    std::unique_ptr<s57::MemoryBudget> memoryBudget;
+    if (opts.maxMemory > 0) {
+        memoryBudget = std::make_unique<s57::MemoryBudget>(opts.maxMemory);
+        ingest.setMemoryBudget(memoryBudget.get());
+    }
     ingest.setVerbose(opts.verbose);
+    ingest.setEncodeOptions(opts.encode);
     
     // Set progress callback
     if (!opts.verbose) {
@@ -237,15 +939,94 @@ int main(int argc, char* argv[]) {
         });
     }
     
+    // Watch mode: the workers and their connections stay up, and cells are
+    // queued as the watcher sees them settle
+    if (opts.watch) {
+        s57::DirectoryWatcher watcher(inputPath, opts.recursive, opts.watchDebounceMs);
+        if (!watcher.isOpen()) {
+            std::cerr << "Error: Failed to watch " << inputPath << std::endl;
+            return 1;
+        }
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+        
+        ingest.setProgressCallback([](int current, int, const std::string& fileName) {
+            std::cout << "[" << current << "] " << fileName << std::endl;
+        });
+        
+        s57::CellQueue queue;
+        std::thread pool([&ingest, &queue]() { ingest.processQueue(queue, false); });
+        
+        // With a journal, catch up on whatever changed while not running
+        if (journal) {
+            for (auto& cell : s57::ChartIngest::findCells(inputPath, opts.recursive)) {
+                queue.push(std::move(cell));
+            }
+        }
+        
+        std::cout << "Watching " << inputPath << " (Ctrl-C to stop)" << std::endl;
+        watcher.run(stopRequested, [&queue](const std::string& path) {
+            queue.push(s57::findCell(path));
+        });
+        
+        std::cout << "Stopping, finishing queued charts..." << std::endl;
+        queue.close();
+        pool.join();
+        
+        auto stats = ingest.getStatistics();
+        std::cout << "Ingested " << stats.successCount << " charts, "
+                  << stats.failCount << " failed, " << stats.skippedCount << " unchanged" << std::endl;
+        return stats.failCount > 0 ? 1 : 0;
+    }
+    
     // Process input
     std::vector<s57::ProcessingResult> results;
     
-    if (fs::is_regular_file(inputPath)) {
+    if (!opts.queueName.empty()) {
+        s57::WorkQueue queue(opts.databaseUrl, opts.queueName, opts.queueLeaseSeconds);
+        if (!queue.isOpen()) {
+            std::cerr << "Error: Failed to connect to database" << std::endl;
+            return 1;
+        }
+        if (!inputPath.empty()) {
+            auto cells = s57::ChartIngest::findCells(inputPath, opts.recursive);
+            int added = queue.enqueue(cells);
+            if (added < 0) {
+                std::cerr << "Error: Failed to queue charts" << std::endl;
+                return 1;
+            }
+            std::cout << "Queued " << added << " of " << cells.size() << " charts in "
+                      << opts.queueName << std::endl;
+        }
+        
+        ingest.setProgressCallback([](int current, int, const std::string& fileName) {
+            std::cout << "[" << current << "] " << fileName << std::endl;
+        });
+        std::cout << "Working on queue " << opts.queueName << " as " << queue.workerId() << std::endl;
+        results = ingest.processWorkQueue(queue);
+        if (ingest.getStatistics().outputFailed) {
+            std::cerr << "Error: No worker could open its output; cells are left to other workers"
+                      << std::endl;
+            return 1;
+        }
+        if (queue.failed()) {
+            std::cerr << "Error: Lost the queue; cells still claimed are handed out again "
+                      << "once their lease runs out" << std::endl;
+            return 1;
+        }
+    } else if (!archive && fs::is_regular_file(inputPath)) {
         // Single file
-        auto result = ingest.processFile(inputPath);
-        results.push_back(result);
+        results = ingest.processFiles({inputPath});
+    } else if (!opts.shard.empty()) {
+        // Every host lists all cells and keeps its own slice
+        auto cells = s57::ChartIngest::findCells(inputPath, opts.recursive);
+        auto selected = s57::selectShard(cells, shard);
+        std::cout << "Shard " << shard.index << "/" << shard.count << ": "
+                  << selected.size() << " of " << cells.size() << " charts" << std::endl;
+        
+        results = ingest.processCells(selected);
     } else {
-        // Directory
+        // Directory or zip/tar archive
         results = ingest.processDirectory(inputPath, opts.recursive);
     }
     
@@ -254,12 +1035,93 @@ int main(int argc, char* argv[]) {
         std::cout << std::endl;
     }
     
+    if (db && opts.staging) {
+        std::cout << "Merging " << stagingSuffixes.size() << " staging sessions..." << std::endl;
+        if (!db->mergeStaging(stagingSuffixes)) {
+            std::cerr << "Error: Failed to merge staged charts" << std::endl;
+            return 1;
+        }
+    }
+    
+    if (tileExport) {
+        std::cout << "Generating tiles..." << std::endl;
+        if (!tileExport->finish()) {
+            std::cerr << "Error: Failed to generate tiles" << std::endl;
+            return 1;
+        }
+        std::cout << "Tiles written to " << opts.tilesPath << std::endl;
+    }
+    
+    if (vectorExport) {
+        if (!vectorExport->finish()) {
+            std::cerr << "Error: Failed to finish export" << std::endl;
+            return 1;
+        }
+        std::cout << "Export written to " << opts.exportPath << std::endl;
+    }
+    
+    if (dump) {
+        if (!dump->finish()) {
+            std::cerr << "Error: Failed to finish dump" << std::endl;
+            return 1;
+        }
+        std::cout << "Dump written to " << opts.dumpDir 
+                  << " (load with " << (fs::path(opts.dumpDir) / "load.sh").string() << ")" << std::endl;
+    }
+    
+    if (db && opts.bulkLoad) {
+        std::cout << "Building indexes..." << std::endl;
+        if (!db->finishBulkLoad(opts.workers)) {
+            std::cerr << "Error: Failed to build indexes" << std::endl;
+            return 1;
+        }
+    }
+    
+    // Ownership only changes where coverage changed, so this stays cheap.
+    // Sharded runs leave it to --shard-summary once every shard is in.
+    if (db && (opts.quilt || opts.quiltRebuild) && shard.count == 1) {
+        std::cout << "Updating chart quilt..." << std::endl;
+        if (!db->updateQuilt(opts.quiltRebuild)) {
+            std::cerr << "Error: Failed to update chart quilt" << std::endl;
+            return 1;
+        }
+    }
+    
     auto stats = ingest.getStatistics();
+    if (db && !opts.shard.empty()) {
+        s57::IngestSummary summary;
+        summary.runId = opts.runId;
+        summary.shard = shard.index;
+        summary.shardCount = shard.count;
+        summary.host = hostName();
+        summary.files = stats.totalFiles;
+        summary.succeeded = stats.successCount;
+        summary.failed = stats.failCount;
+        summary.skipped = stats.skippedCount;
+        summary.features = stats.totalFeatures;
+        for (const auto& result : results) {
+            if (!result.success) {
+                summary.failures.push_back(result.fileName + ": " + result.errorMessage);
+            }
+        }
+        if (!db->recordIngestSummary(summary)) {
+            std::cerr << "Error: Failed to record shard result" << std::endl;
+            return 1;
+        }
+        std::cout << "Recorded shard " << shard.index << "/" << shard.count
+                  << " of run " << opts.runId << std::endl;
+    }
+    
     std::cout << "\nProcessing Complete:\n"
               << "  Files processed: " << stats.totalFiles << "\n"
               << "  Successful:      " << stats.successCount << "\n"
               << "  Failed:          " << stats.failCount << "\n"
+              << "  Skipped:         " << stats.skippedCount << "\n"
               << "  Total features:  " << stats.totalFeatures << "\n";
+    if (memoryBudget) {
+        std::cout << "  Peak reserved:   " << memoryBudget->peak() / (1024 * 1024) << " of "
+                  << memoryBudget->limit() / (1024 * 1024) << " MB\n";
+    }
     
     // Print failures
     if (stats.failCount > 0) {
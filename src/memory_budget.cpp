@@ -0,0 +1,158 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Ingest memory budget implementation
+
+#include "memory_budget.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+
+namespace s57 {
+
+MemoryBudget::MemoryBudget(size_t limitBytes) : limit_(limitBytes) {
+}
+
+void MemoryBudget::acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // First come, first served: a later, smaller request must not slip in
+    // ahead of one waiting for the budget to drain
+    uint64_t ticket = nextTicket_++;
+    released_.wait(lock, [&]() {
+        return ticket == admitted_ && (reserved_ == 0 || reserved_ + bytes <= limit_);
+    });
+    ++admitted_;
+    reserved_ += bytes;
+    peak_ = std::max(peak_, reserved_);
+    lock.unlock();
+    released_.notify_all();
+}
+
+void MemoryBudget::adjust(size_t from, size_t to) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved_ = reserved_ - std::min(reserved_, from) + to;
+    peak_ = std::max(peak_, reserved_);
+    if (to < from) {
+        released_.notify_all();
+    }
+}
+
+void MemoryBudget::release(size_t bytes) {
+    adjust(bytes, 0);
+}
+
+size_t MemoryBudget::estimate(uintmax_t fileBytes) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double expansion = expansion_ > 0.0 ? expansion_ : DEFAULT_EXPANSION;
+    return static_cast<size_t>(static_cast<double>(fileBytes) * expansion);
+}
+
+void MemoryBudget::observe(uintmax_t fileBytes, size_t parsedBytes) {
+    if (fileBytes == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The largest ratio so far; underestimates are what overshoot the limit
+    expansion_ = std::max(expansion_, static_cast<double>(parsedBytes) / static_cast<double>(fileBytes));
+}
+
+size_t MemoryBudget::limit() const {
+    return limit_;
+}
+
+size_t MemoryBudget::peak() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
+}
+
+MemoryReservation::MemoryReservation(MemoryBudget* budget, size_t bytes) : budget_(budget) {
+    if (budget_) {
+        budget_->acquire(bytes);
+        bytes_ = bytes;
+    }
+}
+
+MemoryReservation::~MemoryReservation() {
+    if (budget_) {
+        budget_->release(bytes_);
+    }
+}
+
+void MemoryReservation::resize(size_t bytes) {
+    if (budget_) {
+        budget_->adjust(bytes_, bytes);
+        bytes_ = bytes;
+    }
+}
+
+size_t MemoryReservation::bytes() const {
+    return bytes_;
+}
+
+bool parseByteSize(const std::string& text, size_t& bytes) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+
+    size_t pos = 0;
+    unsigned long long value = 0;
+    try {
+        value = std::stoull(text, &pos);
+    } catch (const std::exception&) {
+        return false;  // Out of range
+    }
+    std::string unit = text.substr(pos);
+    if (!unit.empty() && (unit.back() == 'B' || unit.back() == 'b')) unit.pop_back();
+
+    int shift = 0;
+    if (unit.empty()) {
+        shift = 0;
+    } else if (unit.size() == 1) {
+        switch (std::toupper(static_cast<unsigned char>(unit[0]))) {
+            case 'K': shift = 10; break;
+            case 'M': shift = 20; break;
+            case 'G': shift = 30; break;
+            case 'T': shift = 40; break;
+            default: return false;
+        }
+    } else {
+        return false;
+    }
+
+    // value << shift must not wrap
+    if (value > (static_cast<unsigned long long>(SIZE_MAX) >> shift)) return false;
+    bytes = static_cast<size_t>(value << shift);
+    return bytes > 0;
+}
+
+size_t featureBytes(const Feature& feature) {
+    size_t bytes = sizeof(Feature) + feature.layer.capacity() + feature.geomGeoJson.capacity() +
+                   feature.propsJson.capacity() + feature.lnam.capacity() +
+                   feature.lnamRefKinds.capacity() * sizeof(int);
+    for (const auto& ref : feature.lnamRefs) {
+        bytes += sizeof(std::string) + ref.capacity();
+    }
+    for (const auto& lod : feature.lods) {
+        bytes += sizeof(GeometryLod) + lod.geomGeoJson.capacity();
+    }
+    for (const auto& part : feature.parts) {
+        bytes += sizeof(std::string) + part.capacity();
+    }
+    return bytes;
+}
+
+size_t featureBytes(const std::vector<Feature>& features) {
+    size_t bytes = 0;
+    for (const auto& feature : features) {
+        bytes += featureBytes(feature);
+    }
+    return bytes;
+}
+
+size_t soundingBytes(const SoundingSet& soundings) {
+    size_t bytes = soundings.soundings.capacity() * sizeof(Sounding);
+    for (const auto& attrs : soundings.attrs) {
+        bytes += sizeof(SoundingAttrs) + attrs.propsJson.capacity();
+    }
+    return bytes;
+}
+
+} // namespace s57
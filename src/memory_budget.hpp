@@ -0,0 +1,110 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Ingest memory budget header
+
+#ifndef S57_POSTGIS_MEMORY_BUDGET_HPP
+#define S57_POSTGIS_MEMORY_BUDGET_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace s57 {
+
+// MemoryBudget caps the memory the ingest workers hold at once (--max-memory).
+// A worker reserves an estimate before it opens a chart and waits while
+// the other workers' reservations leave no room; once the chart is parsed
+// the reservation is corrected to the measured size of its features, and
+// it shrinks again as batches are written. Waiting workers are admitted in
+// arrival order, so smaller charts can't starve a large one; a chart
+// larger than the whole budget is admitted once nothing else is reserved,
+// so it can't deadlock.
+//
+// The cap is soft after admission: a chart that parses larger than its
+// estimate keeps the memory it has built (the reservation grows past the
+// limit without waiting, as a worker can't wait for room while holding
+// it), and later charts wait until the total is back under the limit.
+//
+// Estimates scale the cell's file size by the largest parsed/file ratio
+// seen so far (DEFAULT_EXPANSION until the first chart is measured).
+class MemoryBudget {
+public:
+    // Bytes of parsed output per byte of S-57 before any chart is measured
+    static constexpr double DEFAULT_EXPANSION = 12.0;
+
+    explicit MemoryBudget(size_t limitBytes);
+
+    // Prevent copying
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    // Reserve bytes, waiting for room and for earlier callers
+    void acquire(size_t bytes);
+
+    // Change a reservation without waiting (for corrections after parsing);
+    // may take the total past the limit
+    void adjust(size_t from, size_t to);
+
+    // Return bytes to the budget
+    void release(size_t bytes);
+
+    // Estimated peak for a cell of fileBytes (base cell and updates)
+    size_t estimate(uintmax_t fileBytes) const;
+
+    // Learn from a measured chart
+    void observe(uintmax_t fileBytes, size_t parsedBytes);
+
+    size_t limit() const;
+    size_t peak() const;
+
+private:
+    size_t limit_;
+    size_t reserved_ = 0;
+    size_t peak_ = 0;
+    double expansion_ = 0.0;
+    uint64_t nextTicket_ = 0;   // Handed to each acquire() in arrival order
+    uint64_t admitted_ = 0;     // Ticket allowed to reserve next
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+};
+
+// A worker's share of a MemoryBudget, released on destruction.
+// With a null budget every call is a no-op.
+class MemoryReservation {
+public:
+    // Reserve bytes from budget, waiting for room
+    MemoryReservation(MemoryBudget* budget, size_t bytes);
+    ~MemoryReservation();
+
+    // Prevent copying
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+    // Set the reservation to bytes without waiting (even past the limit)
+    void resize(size_t bytes);
+
+    size_t bytes() const;
+
+private:
+    MemoryBudget* budget_;
+    size_t bytes_ = 0;
+};
+
+// Parse a byte size such as "512M", "4G" or "1500000" (K/M/G/T are
+// powers of 1024); false if it isn't one
+bool parseByteSize(const std::string& text, size_t& bytes);
+
+// Heap held by parsed features (strings, LODs, parts and references)
+size_t featureBytes(const Feature& feature);
+size_t featureBytes(const std::vector<Feature>& features);
+
+// Heap held by a chart's compact soundings
+size_t soundingBytes(const SoundingSet& soundings);
+
+} // namespace s57
+
+#endif // S57_POSTGIS_MEMORY_BUDGET_HPP
@@ -0,0 +1,148 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Chart metadata report implementation
+
+#include "report.hpp"
+#include "s57.hpp"
+#include "json_utils.hpp"
+#include "copy_utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+namespace s57 {
+
+namespace {
+    const char* CSV_HEADER =
+        "file,name,scale,zoom,edition,update,issued,updated,"
+        "min_x,min_y,max_x,max_y,hkey,size,error";
+
+    // Quote a CSV field when it contains a separator, quote or newline
+    std::string csvField(const std::string& value) {
+        if (value.find_first_of(",\"\r\n") == std::string::npos) return value;
+        std::string quoted = "\"";
+        for (char c : value) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        quoted += '"';
+        return quoted;
+    }
+
+    std::string jsonString(const std::string& value) {
+        return "\"" + json::escapeString(value) + "\"";
+    }
+
+    std::string reportLine(const std::string& filePath, const ChartInfo& info,
+                           uintmax_t size, const std::string& error, ReportFormat format) {
+        const BoundingBox& bbox = info.bbox;
+        std::ostringstream line;
+
+        if (format == ReportFormat::Csv) {
+            line << csvField(filePath) << ',' << csvField(info.name) << ','
+                 << info.scale << ',' << info.zoom << ','
+                 << csvField(info.edition) << ',' << csvField(info.updateNumber) << ','
+                 << csvField(info.issued) << ',' << csvField(info.updated) << ',';
+            if (bbox.valid) {
+                line << pgcopy::number(bbox.minX) << ',' << pgcopy::number(bbox.minY) << ','
+                     << pgcopy::number(bbox.maxX) << ',' << pgcopy::number(bbox.maxY) << ','
+                     << info.hkey;
+            } else {
+                line << ",,,,";
+            }
+            line << ',' << size << ',' << csvField(error);
+            return line.str();
+        }
+
+        line << "{\"file\":" << jsonString(filePath);
+        if (error.empty()) {
+            line << ",\"name\":" << jsonString(info.name)
+                 << ",\"scale\":" << info.scale
+                 << ",\"zoom\":" << info.zoom
+                 << ",\"edition\":" << jsonString(info.edition)
+                 << ",\"update\":" << jsonString(info.updateNumber)
+                 << ",\"issued\":" << jsonString(info.issued)
+                 << ",\"updated\":" << jsonString(info.updated);
+            if (bbox.valid) {
+                line << ",\"bbox\":[" << pgcopy::number(bbox.minX) << ',' << pgcopy::number(bbox.minY) << ','
+                     << pgcopy::number(bbox.maxX) << ',' << pgcopy::number(bbox.maxY) << ']'
+                     << ",\"hkey\":" << info.hkey;
+            }
+        }
+        line << ",\"size\":" << size;
+        if (!error.empty()) {
+            line << ",\"error\":" << jsonString(error);
+        }
+        line << '}';
+        return line.str();
+    }
+}
+
+bool parseReportFormat(const std::string& name, ReportFormat& format) {
+    if (name == "csv") {
+        format = ReportFormat::Csv;
+        return true;
+    }
+    if (name == "json" || name == "jsonl") {
+        format = ReportFormat::JsonLines;
+        return true;
+    }
+    return false;
+}
+
+int writeChartReport(const std::vector<CellFile>& cells,
+                     const ReportOptions& options, std::ostream& out) {
+    if (options.format == ReportFormat::Csv) {
+        out << CSV_HEADER << '\n';
+    }
+
+    std::vector<std::optional<std::string>> lines(cells.size());
+    std::atomic<size_t> nextFile{0};
+    std::atomic<int> failed{0};
+    std::mutex outputMutex;
+    size_t nextLine = 0;
+
+    auto worker = [&]() {
+        for (size_t i = nextFile++; i < cells.size(); i = nextFile++) {
+            ChartInfo info;
+            std::string error;
+            S57 chart(cells[i].path);
+            if (chart.isOpen()) {
+                info = chart.getChartMetadata();
+            } else {
+                error = "failed to open";
+                failed++;
+            }
+            std::string line = reportLine(cells[i].path, info, cells[i].size, error, options.format);
+
+            // Emit every line that is now next in input order
+            std::lock_guard<std::mutex> lock(outputMutex);
+            lines[i] = std::move(line);
+            while (nextLine < lines.size() && lines[nextLine]) {
+                out << *lines[nextLine] << '\n';
+                lines[nextLine].reset();
+                ++nextLine;
+            }
+        }
+    };
+
+    size_t threadCount = std::min(cells.size(), static_cast<size_t>(std::max(1, options.workers)));
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    out.flush();
+    return failed;
+}
+
+} // namespace s57
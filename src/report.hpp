@@ -0,0 +1,42 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Chart metadata report header
+
+#ifndef S57_POSTGIS_REPORT_HPP
+#define S57_POSTGIS_REPORT_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace s57 {
+
+// Output format of a chart report
+enum class ReportFormat {
+    Csv,        // Header line, then one CSV row per file
+    JsonLines   // One JSON object per file
+};
+
+// Options for writeChartReport
+struct ReportOptions {
+    ReportFormat format = ReportFormat::Csv;
+    int workers = 4;
+};
+
+// Parse a report format name ("csv", "json" or "jsonl")
+bool parseReportFormat(const std::string& name, ReportFormat& format);
+
+// Scan the metadata of many charts and write one line per cell, in input
+// order, for planning an ingest. Sizes are the cells' (base plus
+// updates). Workers read only DSID and the M_COVR envelope
+// (S57::getChartMetadata); lines are written as soon as all earlier
+// files are done, so output streams while the scan runs.
+// Returns the number of files that could not be opened.
+int writeChartReport(const std::vector<CellFile>& cells,
+                     const ReportOptions& options, std::ostream& out);
+
+} // namespace s57
+
+#endif // S57_POSTGIS_REPORT_HPP
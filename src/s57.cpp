@@ -7,6 +7,7 @@
 #include "s57.hpp"
 #include "zfinder.hpp"
 #include "json_utils.hpp"
+#include "geometry.hpp"
 
 #include <gdal.h>
 #include <ogrsf_frmts.h>
@@ -17,6 +18,8 @@
 #include <iomanip>
 #include <filesystem>
 #include <cstring>
+#include <unordered_map>
+#include <limits>
 
 namespace s57 {
 
@@ -36,6 +39,23 @@ namespace {
         static GDALInit init;
         return init;
     }
+
+    // Transform a geometry to WGS84 in place if it has another SRS
+    void toWgs84(OGRGeometry* geometry) {
+        OGRSpatialReference wgs84;
+        wgs84.SetWellKnownGeogCS("WGS84");
+        wgs84.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+
+        const OGRSpatialReference* srcSRS = geometry->getSpatialReference();
+        if (srcSRS && !srcSRS->IsSame(&wgs84)) {
+            OGRCoordinateTransformation* transform = 
+                OGRCreateCoordinateTransformation(srcSRS, &wgs84);
+            if (transform) {
+                geometry->transform(transform);
+                OGRCoordinateTransformation::DestroyCT(transform);
+            }
+        }
+    }
 }
 
 S57::S57(const std::string& filePath) : filePath_(filePath) {
@@ -58,7 +78,11 @@ S57::~S57() {
 S57::S57(S57&& other) noexcept 
     : filePath_(std::move(other.filePath_))
     , dataset_(other.dataset_)
-    , initialized_(other.initialized_) {
+    , initialized_(other.initialized_)
+    , encodeOptions_(other.encodeOptions_)
+    , chartZoom_(other.chartZoom_)
+    , gridSize_(other.gridSize_)
+    , zGridSize_(other.zGridSize_) {
     other.dataset_ = nullptr;
     other.initialized_ = false;
 }
@@ -71,6 +95,10 @@ S57& S57::operator=(S57&& other) noexcept {
         filePath_ = std::move(other.filePath_);
         dataset_ = other.dataset_;
         initialized_ = other.initialized_;
+        encodeOptions_ = other.encodeOptions_;
+        chartZoom_ = other.chartZoom_;
+        gridSize_ = other.gridSize_;
+        zGridSize_ = other.zGridSize_;
         other.dataset_ = nullptr;
         other.initialized_ = false;
     }
@@ -85,6 +113,54 @@ const std::string& S57::getFilePath() const {
     return filePath_;
 }
 
+void S57::setEncodeOptions(const EncodeOptions& options) {
+    encodeOptions_ = options;
+}
+
+void S57::loadDsidParameters() const {
+    if (chartZoom_ >= 0) return;
+
+    chartZoom_ = 0;
+    long comf = 0;
+    long somf = 0;
+    auto dsidProps = getDsidProperties();
+
+    auto it = dsidProps.find("DSPM_CSCL");
+    if (it != dsidProps.end()) {
+        try {
+            int scale = std::stoi(it->second);
+            if (scale > 0) {
+                chartZoom_ = ZFinder::findZoom(scale);
+            }
+        } catch (...) {}
+    }
+
+    it = dsidProps.find("DSPM_COMF");
+    if (it != dsidProps.end()) {
+        try {
+            comf = std::stol(it->second);
+        } catch (...) {}
+    }
+
+    it = dsidProps.find("DSPM_SOMF");
+    if (it != dsidProps.end()) {
+        try {
+            somf = std::stol(it->second);
+        } catch (...) {}
+    }
+
+    // Coordinates can't be more precise than the grid they were encoded on
+    gridSize_ = encodeOptions_.precision >= 0
+        ? geometry::decimalGridSize(encodeOptions_.precision)
+        : geometry::comfGridSize(comf);
+    zGridSize_ = somf > 0 ? 1.0 / static_cast<double>(somf) : 0.0;
+}
+
+int S57::getChartZoom() const {
+    loadDsidParameters();
+    return chartZoom_;
+}
+
 std::vector<std::string> S57::getLayerNames() const {
     std::vector<std::string> names;
     if (!isOpen()) return names;
@@ -131,18 +207,13 @@ std::string S57::geometryToGeoJson(void* geometryPtr) const {
     if (!geometry) return "{}";
 
     // Transform to WGS84 if needed
-    OGRSpatialReference wgs84;
-    wgs84.SetWellKnownGeogCS("WGS84");
-    wgs84.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
-
-    const OGRSpatialReference* srcSRS = geometry->getSpatialReference();
-    if (srcSRS && !srcSRS->IsSame(&wgs84)) {
-        OGRCoordinateTransformation* transform = 
-            OGRCreateCoordinateTransformation(srcSRS, &wgs84);
-        if (transform) {
-            geometry->transform(transform);
-            OGRCoordinateTransformation::DestroyCT(transform);
-        }
+    toWgs84(geometry);
+
+    // Compact GeoJSON on the coordinate grid
+    if (encodeOptions_.quantize) {
+        loadDsidParameters();
+        std::string quantized = geometry::toQuantizedGeoJson(geometry, gridSize_, zGridSize_);
+        if (!quantized.empty()) return quantized;
     }
 
     // Export to GeoJSON
@@ -193,45 +264,76 @@ std::map<std::string, std::string> S57::getDsidProperties() const {
 
 std::map<std::string, std::string> S57::getMCovrProperties() const {
     std::map<std::string, std::string> props;
-    if (!isOpen()) return props;
-
-    OGRLayer* mcovrLayer = dataset_->GetLayerByName("M_COVR");
-    if (!mcovrLayer) return props;
-
-    mcovrLayer->ResetReading();
-    OGRFeature* feature = mcovrLayer->GetNextFeature();
-    if (feature) {
-        props = extractProperties(feature);
-        OGRFeature::DestroyFeature(feature);
-    }
-    
+    readCoverage(nullptr, nullptr, &props);
     return props;
 }
 
 std::string S57::getCoverageGeoJson() const {
-    if (!isOpen()) return "{}";
+    std::string result = "{}";
+    readCoverage(&result, nullptr, nullptr);
+    return result;
+}
+
+void S57::readCoverage(std::string* geoJson, BoundingBox* bbox,
+                       std::map<std::string, std::string>* props) const {
+    if (!isOpen()) return;
 
     OGRLayer* mcovrLayer = dataset_->GetLayerByName("M_COVR");
-    if (!mcovrLayer) return "{}";
+    if (!mcovrLayer) return;
+
+    OGRGeometry* coverage = nullptr;
+    bool haveProps = false;
 
     mcovrLayer->ResetReading();
-    OGRFeature* feature = mcovrLayer->GetNextFeature();
-    if (!feature) return "{}";
+    OGRFeature* feature;
+    while ((feature = mcovrLayer->GetNextFeature()) != nullptr) {
+        // CATCOV 2 marks areas without data
+        int catcovIndex = feature->GetFieldIndex("CATCOV");
+        if (catcovIndex >= 0 && feature->IsFieldSet(catcovIndex) &&
+            feature->GetFieldAsInteger(catcovIndex) == 2) {
+            OGRFeature::DestroyFeature(feature);
+            continue;
+        }
 
-    OGRGeometry* geometry = feature->GetGeometryRef();
-    std::string result = geometryToGeoJson(geometry);
-    OGRFeature::DestroyFeature(feature);
-    
-    return result;
-}
+        if (props && !haveProps) {
+            *props = extractProperties(feature);
+            haveProps = true;
+        }
 
-ChartInfo S57::getChartInfo() const {
-    ChartInfo info;
-    if (!isOpen()) return info;
+        OGRGeometry* geometry = feature->GetGeometryRef();
+        if (geometry && !geometry->IsEmpty()) {
+            toWgs84(geometry);
+            if (bbox) {
+                geometry::expand(*bbox, geometry::envelope(geometry));
+            }
+            if (geoJson) {
+                if (!coverage) {
+                    coverage = geometry->clone();
+                } else {
+                    // Without GEOS, keep the first coverage polygon
+                    OGRGeometry* merged = coverage->Union(geometry);
+                    if (merged) {
+                        OGRGeometryFactory::destroyGeometry(coverage);
+                        coverage = merged;
+                    }
+                }
+            }
+        }
+        OGRFeature::DestroyFeature(feature);
 
-    // Get DSID properties
-    auto dsidProps = getDsidProperties();
-    
+        // Only the first feature matters when neither geometry nor bbox is wanted
+        if (!geoJson && !bbox && haveProps) break;
+    }
+
+    if (geoJson && coverage) {
+        *geoJson = geometryToGeoJson(coverage);
+    }
+    if (coverage) {
+        OGRGeometryFactory::destroyGeometry(coverage);
+    }
+}
+
+void S57::fillDsidInfo(ChartInfo& info, const std::map<std::string, std::string>& dsidProps) const {
     // Chart name from DSNM
     auto it = dsidProps.find("DSNM");
     if (it != dsidProps.end()) {
@@ -263,6 +365,16 @@ ChartInfo S57::getChartInfo() const {
         info.issued = it->second;
     }
 
+    // Edition and update number
+    it = dsidProps.find("EDTN");
+    if (it != dsidProps.end()) {
+        info.edition = it->second;
+    }
+    it = dsidProps.find("UPDN");
+    if (it != dsidProps.end()) {
+        info.updateNumber = it->second;
+    }
+
     // File name
     info.fileName = std::filesystem::path(filePath_).filename().string();
 
@@ -270,15 +382,38 @@ ChartInfo S57::getChartInfo() const {
     if (info.scale > 0) {
         info.zoom = ZFinder::findZoom(info.scale);
     }
+}
 
-    // Coverage geometry
-    info.covrGeoJson = getCoverageGeoJson();
+ChartInfo S57::getChartInfo() const {
+    return readChartInfo(true);
+}
+
+ChartInfo S57::getChartMetadata() const {
+    return readChartInfo(false);
+}
+
+ChartInfo S57::readChartInfo(bool withCoverage) const {
+    ChartInfo info;
+    if (!isOpen()) return info;
+
+    // DSID fields
+    auto dsidProps = getDsidProperties();
+    fillDsidInfo(info, dsidProps);
+
+    if (!withCoverage) {
+        readCoverage(nullptr, &info.bbox, nullptr);
+        info.hkey = geometry::hilbertKey(info.bbox);
+        return info;
+    }
 
     // DSID properties as JSON
     info.dsidProps = json::toJsonObject(dsidProps);
 
-    // M_COVR properties as chart text
-    auto mcovrProps = getMCovrProperties();
+    // Coverage geometry and M_COVR properties as chart text, in one pass
+    std::map<std::string, std::string> mcovrProps;
+    info.covrGeoJson = "{}";
+    readCoverage(&info.covrGeoJson, &info.bbox, &mcovrProps);
+    info.hkey = geometry::hilbertKey(info.bbox);
     info.chartTxt = json::toJsonObject(mcovrProps);
 
     return info;
@@ -327,6 +462,9 @@ std::vector<Feature> S57::getLayerFeatures(const std::string& layerName) const {
         OGRGeometry* geometry = ogrFeature->GetGeometryRef();
         if (geometry) {
             feat.geomGeoJson = geometryToGeoJson(geometry);
+            // geometryToGeoJson reprojected in place, so this is WGS84
+            feat.bbox = geometry::envelope(geometry);
+            feat.hkey = geometry::hilbertKey(feat.bbox);
         }
 
         // Properties to JSON
@@ -337,6 +475,28 @@ std::vector<Feature> S57::getLayerFeatures(const std::string& layerName) const {
         feat.minZ = minZ;
         feat.maxZ = maxZ;
 
+        // Simplified variants for the zooms below the chart's own
+        if (geometry && encodeOptions_.generalize) {
+            for (const auto& variant : geometry::generalize(geometry, minZ, std::min(maxZ, getChartZoom()))) {
+                feat.lods.push_back({variant.minZ, variant.maxZ, geometryToGeoJson(variant.geometry)});
+                OGRGeometryFactory::destroyGeometry(variant.geometry);
+            }
+        }
+
+        // Small pieces of large areas, so spatial lookups don't hit the whole thing
+        if (geometry && encodeOptions_.subdivideVertices > 0) {
+            for (OGRGeometry* piece : geometry::subdivide(geometry, encodeOptions_.subdivideVertices)) {
+                std::string pieceJson = geometryToGeoJson(piece);
+                if (pieceJson != "{}") feat.parts.push_back(std::move(pieceJson));
+                OGRGeometryFactory::destroyGeometry(piece);
+            }
+        }
+
+        auto lnamIt = props.find("LNAM");
+        if (lnamIt != props.end()) {
+            feat.lnam = lnamIt->second;
+        }
+
         // Extract LNAM_REFS if present
         int lnamRefsIdx = ogrFeature->GetFieldIndex("LNAM_REFS");
         if (lnamRefsIdx >= 0 && ogrFeature->IsFieldSet(lnamRefsIdx)) {
@@ -350,6 +510,16 @@ std::vector<Feature> S57::getLayerFeatures(const std::string& layerName) const {
             }
         }
 
+        // Relationship indicators, parallel to LNAM_REFS
+        int rindIdx = ogrFeature->GetFieldIndex("FFPT_RIND");
+        if (rindIdx >= 0 && ogrFeature->IsFieldSet(rindIdx)) {
+            int count = 0;
+            const int* rinds = ogrFeature->GetFieldAsIntegerList(rindIdx, &count);
+            if (rinds) {
+                feat.lnamRefKinds.assign(rinds, rinds + count);
+            }
+        }
+
         features.push_back(std::move(feat));
         OGRFeature::DestroyFeature(ogrFeature);
     }
@@ -363,6 +533,7 @@ std::vector<Feature> S57::getAllFeatures() const {
 
     auto layerNames = getLayerNames();
     for (const auto& layerName : layerNames) {
+        if (encodeOptions_.compactSoundings && layerName == "SOUNDG") continue;
         if (!isExcludedLayer(layerName)) {
             auto features = getLayerFeatures(layerName);
             allFeatures.insert(allFeatures.end(), 
@@ -374,11 +545,112 @@ std::vector<Feature> S57::getAllFeatures() const {
     return allFeatures;
 }
 
+SoundingSet S57::getSoundings() const {
+    SoundingSet result;
+    if (!isOpen()) return result;
+
+    OGRLayer* layer = dataset_->GetLayerByName("SOUNDG");
+    if (!layer) return result;
+
+    if (encodeOptions_.quantize) {
+        loadDsidParameters();
+    }
+
+    // With SPLIT_MULTIPOINT every sounding repeats its parent's attributes;
+    // identical attribute sets are stored once
+    std::map<std::string, int> attrsIndex;
+
+    layer->ResetReading();
+    OGRFeature* ogrFeature;
+    while ((ogrFeature = layer->GetNextFeature()) != nullptr) {
+        OGRGeometry* geometry = ogrFeature->GetGeometryRef();
+        if (!geometry) {
+            OGRFeature::DestroyFeature(ogrFeature);
+            continue;
+        }
+
+        auto props = extractProperties(ogrFeature);
+        std::string propsJson = json::toJsonObject(props);
+        auto it = attrsIndex.find(propsJson);
+        if (it == attrsIndex.end()) {
+            auto [minZ, maxZ] = getScaleRange(props);
+            it = attrsIndex.emplace(propsJson, static_cast<int>(result.attrs.size())).first;
+            result.attrs.push_back({std::move(propsJson), minZ, maxZ});
+        }
+
+        auto addPoint = [&](const OGRPoint* point) {
+            Sounding sounding;
+            sounding.lon = point->getX();
+            sounding.lat = point->getY();
+            sounding.depth = point->Is3D() ? point->getZ() : std::numeric_limits<double>::quiet_NaN();
+            sounding.attrs = it->second;
+            if (encodeOptions_.quantize) {
+                sounding.lon = geometry::snapToGrid(sounding.lon, gridSize_);
+                sounding.lat = geometry::snapToGrid(sounding.lat, gridSize_);
+                if (point->Is3D()) {
+                    sounding.depth = geometry::snapToGrid(sounding.depth, zGridSize_);
+                }
+            }
+            result.soundings.push_back(sounding);
+        };
+
+        OGRwkbGeometryType geomType = wkbFlatten(geometry->getGeometryType());
+        if (geomType == wkbPoint) {
+            addPoint(static_cast<const OGRPoint*>(geometry));
+        } else if (geomType == wkbMultiPoint) {
+            auto multiPoint = static_cast<const OGRGeometryCollection*>(geometry);
+            for (int i = 0; i < multiPoint->getNumGeometries(); ++i) {
+                addPoint(static_cast<const OGRPoint*>(multiPoint->getGeometryRef(i)));
+            }
+        }
+
+        OGRFeature::DestroyFeature(ogrFeature);
+    }
+
+    return result;
+}
+
+std::vector<FeatureLink> S57::resolveLinks(const std::vector<Feature>& features) {
+    std::vector<FeatureLink> links;
+
+    std::unordered_map<std::string, size_t> byLnam;
+    byLnam.reserve(features.size());
+    for (size_t i = 0; i < features.size(); ++i) {
+        if (!features[i].lnam.empty()) {
+            byLnam.emplace(features[i].lnam, i);
+        }
+    }
+
+    for (size_t i = 0; i < features.size(); ++i) {
+        const auto& feature = features[i];
+        for (size_t r = 0; r < feature.lnamRefs.size(); ++r) {
+            auto it = byLnam.find(feature.lnamRefs[r]);
+            if (it == byLnam.end()) continue;
+
+            // Collection objects name the relation; otherwise the indicator
+            // tells what the referenced feature is to this one
+            std::string kind;
+            if (feature.layer == "C_AGGR") {
+                kind = "aggregate";
+            } else if (feature.layer == "C_ASSO") {
+                kind = "association";
+            } else {
+                int rind = r < feature.lnamRefKinds.size() ? feature.lnamRefKinds[r] : 0;
+                kind = rind == 1 ? "master" : rind == 2 ? "slave" : "peer";
+            }
+            links.push_back({i, it->second, std::move(kind)});
+        }
+    }
+
+    return links;
+}
+
 void S57::processFeatures(const std::function<void(const Feature&)>& callback) const {
     if (!isOpen()) return;
 
     auto layerNames = getLayerNames();
     for (const auto& layerName : layerNames) {
+        if (encodeOptions_.compactSoundings && layerName == "SOUNDG") continue;
         if (!isExcludedLayer(layerName)) {
             auto features = getLayerFeatures(layerName);
             for (const auto& feat : features) {
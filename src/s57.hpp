@@ -42,9 +42,17 @@ public:
     // Get the file path
     const std::string& getFilePath() const;
 
+    // Set the encode stage options used when reading features
+    void setEncodeOptions(const EncodeOptions& options);
+
     // Get chart metadata
     ChartInfo getChartInfo() const;
 
+    // Get chart metadata for catalog scans: like getChartInfo, but coverage
+    // is kept as its envelope only (covrGeoJson, dsidProps and chartTxt are
+    // left empty)
+    ChartInfo getChartMetadata() const;
+
     // Get list of layer names
     std::vector<std::string> getLayerNames() const;
 
@@ -54,26 +62,58 @@ public:
     // Get all features from all non-excluded layers
     std::vector<Feature> getAllFeatures() const;
 
+    // Get the SOUNDG soundings, with attributes shared per source feature
+    // (getAllFeatures skips SOUNDG when compact soundings are enabled)
+    SoundingSet getSoundings() const;
+
+    // Resolve the LNAM references of a chart's features into links between
+    // their positions; references to features not in the list are dropped
+    static std::vector<FeatureLink> resolveLinks(const std::vector<Feature>& features);
+
     // Process all features with a callback (for streaming)
     void processFeatures(const std::function<void(const Feature&)>& callback) const;
 
     // Get DSID layer properties
     std::map<std::string, std::string> getDsidProperties() const;
 
-    // Get M_COVR layer properties (chart text)
+    // Get M_COVR layer properties (chart text) of the first coverage feature
     std::map<std::string, std::string> getMCovrProperties() const;
 
-    // Get coverage geometry as GeoJSON
+    // Get coverage geometry as GeoJSON (union of all M_COVR coverage)
     std::string getCoverageGeoJson() const;
 
 private:
     std::string filePath_;
     GDALDataset* dataset_ = nullptr;
     bool initialized_ = false;
+    EncodeOptions encodeOptions_;
+    mutable int chartZoom_ = -1;
+    mutable double gridSize_ = 0.0;
+    mutable double zGridSize_ = 0.0;
+
+    // Read chart zoom and COMF/SOMF grid sizes from DSID (once)
+    void loadDsidParameters() const;
+
+    // Chart zoom from DSID (cached)
+    int getChartZoom() const;
+
+    // Fill the DSID-derived ChartInfo fields (name, scale, dates, zoom)
+    void fillDsidInfo(ChartInfo& info, const std::map<std::string, std::string>& dsidProps) const;
 
     // Extract properties from a feature
     std::map<std::string, std::string> extractProperties(void* feature) const;
 
+    // Read ChartInfo with one pass over DSID and one over M_COVR; without
+    // coverage only the M_COVR envelopes are merged
+    ChartInfo readChartInfo(bool withCoverage) const;
+
+    // Read all M_COVR features once. Coverage (CATCOV 1 or unset) is
+    // unioned into geoJson when requested, bbox gets the merged envelope,
+    // and props the attributes of the first coverage feature. Any output
+    // may be null.
+    void readCoverage(std::string* geoJson, BoundingBox* bbox,
+                      std::map<std::string, std::string>* props) const;
+
     // Convert OGR geometry to GeoJSON
     std::string geometryToGeoJson(void* geometry) const;
 
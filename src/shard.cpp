@@ -0,0 +1,94 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Sharded ingest implementation
+
+#include "shard.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <numeric>
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+namespace {
+    // 64-bit FNV-1a; std::hash isn't guaranteed to match across builds
+    uint64_t nameHash(const std::string& name) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : name) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Cell name from the file, so hosts with different mount points agree
+    std::string cellName(const CellFile& cell) {
+        return fs::path(cell.path).stem().string();
+    }
+}
+
+bool parseShardSpec(const std::string& text, ShardSpec& spec) {
+    int index = 0;
+    int count = 0;
+    char trailing = 0;
+    if (std::sscanf(text.c_str(), "%d/%d%c", &index, &count, &trailing) != 2) return false;
+    if (count < 1 || index < 1 || index > count) return false;
+    spec.index = index;
+    spec.count = count;
+    return true;
+}
+
+bool parseShardStrategy(const std::string& name, ShardStrategy& strategy) {
+    if (name == "name") {
+        strategy = ShardStrategy::Name;
+        return true;
+    }
+    if (name == "size") {
+        strategy = ShardStrategy::Size;
+        return true;
+    }
+    return false;
+}
+
+std::vector<CellFile> selectShard(const std::vector<CellFile>& cells, const ShardSpec& spec) {
+    if (spec.count <= 1) return cells;
+
+    std::vector<int> shardOf(cells.size());
+    const auto count = static_cast<uint64_t>(spec.count);
+
+    if (spec.strategy == ShardStrategy::Name) {
+        for (size_t i = 0; i < cells.size(); ++i) {
+            shardOf[i] = static_cast<int>(nameHash(cellName(cells[i])) % count) + 1;
+        }
+    } else {
+        // Longest processing time first: biggest cells onto the least loaded
+        // shard. Ties break on name and shard number so all hosts agree.
+        std::vector<size_t> order(cells.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&cells](size_t a, size_t b) {
+            if (cells[a].size != cells[b].size) return cells[a].size > cells[b].size;
+            return cellName(cells[a]) < cellName(cells[b]);
+        });
+
+        std::vector<uintmax_t> load(spec.count, 0);
+        for (size_t i : order) {
+            auto lightest = std::min_element(load.begin(), load.end()) - load.begin();
+            load[lightest] += std::max<uintmax_t>(cells[i].size, 1);
+            shardOf[i] = static_cast<int>(lightest) + 1;
+        }
+    }
+
+    std::vector<CellFile> selected;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (shardOf[i] == spec.index) {
+            selected.push_back(cells[i]);
+        }
+    }
+    return selected;
+}
+
+} // namespace s57
@@ -0,0 +1,41 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Sharded ingest header
+
+#ifndef S57_POSTGIS_SHARD_HPP
+#define S57_POSTGIS_SHARD_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+
+namespace s57 {
+
+// How charts are assigned to shards
+enum class ShardStrategy {
+    Name,   // Hash of the cell name; stable even if the chart list differs
+    Size    // Largest first onto the least loaded shard; needs the same list
+};
+
+// One host's slice of a sharded ingest (--shard i/N)
+struct ShardSpec {
+    int index = 1;              // 1-based
+    int count = 1;
+    ShardStrategy strategy = ShardStrategy::Name;
+};
+
+// Parse "i/N" with 1 <= i <= N
+bool parseShardSpec(const std::string& text, ShardSpec& spec);
+
+// Parse a strategy name ("name" or "size")
+bool parseShardStrategy(const std::string& name, ShardStrategy& strategy);
+
+// Cells belonging to a shard, in their original order. Every host must
+// pick the same strategy; with Size they must also discover the same
+// cells (e.g. the same CATALOG.031).
+std::vector<CellFile> selectShard(const std::vector<CellFile>& cells, const ShardSpec& spec);
+
+} // namespace s57
+
+#endif // S57_POSTGIS_SHARD_HPP
@@ -0,0 +1,52 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Output sink interface implementation
+
+#include "sink.hpp"
+#include "json_utils.hpp"
+
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+namespace s57 {
+
+std::vector<Feature> soundingFeatures(const SoundingSet& soundings) {
+    std::vector<Feature> features;
+    features.reserve(soundings.soundings.size());
+
+    std::vector<std::map<std::string, std::string>> attrProps;
+    attrProps.reserve(soundings.attrs.size());
+    for (const auto& attrs : soundings.attrs) {
+        attrProps.push_back(json::fromJsonObject(attrs.propsJson));
+    }
+
+    for (const auto& sounding : soundings.soundings) {
+        const auto& attrs = soundings.attrs[sounding.attrs];
+        auto props = attrProps[sounding.attrs];
+
+        // Like S57::getAllFeatures: a 2D sounding has no depth to report
+        Feature feat;
+        feat.layer = "SOUNDG";
+        if (std::isnan(sounding.depth)) {
+            feat.geomGeoJson = json::pointToGeoJson(sounding.lon, sounding.lat);
+        } else {
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(1) << sounding.depth;
+            props["METERS"] = ss.str();
+            feat.geomGeoJson = json::pointToGeoJson(sounding.lon, sounding.lat, sounding.depth);
+        }
+        feat.propsJson = json::toJsonObject(props);
+        feat.minZ = attrs.minZ;
+        feat.maxZ = attrs.maxZ;
+        features.push_back(std::move(feat));
+    }
+    return features;
+}
+
+bool ChartSink::writeSoundings(const SoundingSet& soundings) {
+    return writeFeatures(soundingFeatures(soundings));
+}
+
+} // namespace s57
@@ -0,0 +1,79 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Output sink interface for parsed charts
+
+#ifndef S57_POSTGIS_SINK_HPP
+#define S57_POSTGIS_SINK_HPP
+
+#include "types.hpp"
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+namespace s57 {
+
+// ChartSink receives parsed charts from ChartIngest
+// Each ingest worker owns its own sink, so implementations only need to be
+// thread-safe with respect to state they share between sinks.
+//
+// Call sequence per chart: beginChart, writeFeatures (zero or more batches),
+// writeSoundings (with --compact-soundings), writeLinks, endChart(true) to
+// keep the chart or endChart(false) to discard it.
+class ChartSink {
+public:
+    virtual ~ChartSink() = default;
+
+    // Start a chart, replacing any previous chart with the same name
+    virtual bool beginChart(const ChartInfo& chart) = 0;
+
+    // Write a batch of features belonging to the current chart
+    virtual bool writeFeatures(const std::vector<Feature>& features) = 0;
+
+    // Write the soundings of the current chart
+    // The default writes them as one SOUNDG point feature each
+    virtual bool writeSoundings(const SoundingSet& soundings);
+
+    // Write the LNAM links between the current chart's features
+    // The default ignores them
+    virtual bool writeLinks(const std::vector<FeatureLink>& links) { (void)links; return true; }
+
+    // Finish the current chart
+    virtual bool endChart(bool commit) = 0;
+};
+
+// Expand a sounding set into SOUNDG point features with a METERS property,
+// the way they are read without --compact-soundings
+std::vector<Feature> soundingFeatures(const SoundingSet& soundings);
+
+// Creates the sink for one worker; returns nullptr on failure
+using SinkFactory = std::function<std::unique_ptr<ChartSink>()>;
+
+// NullSink discards everything; used to measure pure parse throughput
+class NullSink : public ChartSink {
+public:
+    bool beginChart(const ChartInfo&) override { return true; }
+
+    bool writeFeatures(const std::vector<Feature>& features) override {
+        featureCount_ += static_cast<int64_t>(features.size());
+        return true;
+    }
+
+    bool writeSoundings(const SoundingSet& soundings) override {
+        featureCount_ += static_cast<int64_t>(soundings.soundings.size());
+        return true;
+    }
+
+    bool endChart(bool) override { return true; }
+
+    // Number of features received
+    int64_t getFeatureCount() const { return featureCount_; }
+
+private:
+    int64_t featureCount_ = 0;
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_SINK_HPP
@@ -0,0 +1,221 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Mapbox Vector Tile pre-generation implementation
+
+#include "tiles.hpp"
+#include "json_utils.hpp"
+
+#include <gdal.h>
+#include <ogrsf_frmts.h>
+#include <cpl_conv.h>
+#include <cpl_string.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+namespace {
+    struct GeometryDeleter {
+        void operator()(OGRGeometry* geometry) const {
+            OGRGeometryFactory::destroyGeometry(geometry);
+        }
+    };
+
+    using GeometryPtr = std::unique_ptr<OGRGeometry, GeometryDeleter>;
+}
+
+// Parses geometry and attributes in the worker, then hands whole charts to
+// the MVT writer under the lock
+class TileExport::TileSink : public ChartSink {
+public:
+    explicit TileSink(TileExport& output) : output_(output) {}
+
+    bool beginChart(const ChartInfo& chart) override {
+        chartName_ = chart.name;
+        minZoom_ = output_.options_.minZoom;
+        if (chart.zoom > 0) {
+            minZoom_ = std::max(minZoom_, chart.zoom - output_.options_.underzoom);
+        }
+        pending_.clear();
+        return true;
+    }
+
+    bool writeFeatures(const std::vector<Feature>& features) override {
+        for (const auto& feature : features) {
+            int minZoom = std::max(feature.minZ, minZoom_);
+            // maxZ is the exclusive end of the feature's z_range
+            int maxZoom = std::min(feature.maxZ - 1, output_.options_.maxZoom);
+            if (minZoom > maxZoom || feature.geomGeoJson.empty()) continue;
+
+            // Split the zoom range into runs drawn from the same geometry:
+            // a generalized variant where one covers the zoom, else the original
+            auto sourceFor = [&feature](int zoom) -> const std::string* {
+                for (const auto& lod : feature.lods) {
+                    if (zoom >= lod.minZ && zoom < lod.maxZ) return &lod.geomGeoJson;
+                }
+                return &feature.geomGeoJson;
+            };
+
+            auto props = json::fromJsonObject(feature.propsJson);
+            int runStart = minZoom;
+            const std::string* source = sourceFor(minZoom);
+            for (int zoom = minZoom + 1; zoom <= maxZoom + 1; ++zoom) {
+                const std::string* next = zoom <= maxZoom ? sourceFor(zoom) : nullptr;
+                if (next == source) continue;
+
+                GeometryPtr geometry(OGRGeometryFactory::createFromGeoJson(source->c_str()));
+                if (geometry) {
+                    pending_.push_back({feature.layer, runStart, zoom - 1, props, std::move(geometry)});
+                }
+                runStart = zoom;
+                source = next;
+            }
+        }
+        return true;
+    }
+
+    bool endChart(bool commit) override {
+        bool ok = !commit || write();
+        pending_.clear();
+        return ok;
+    }
+
+private:
+    struct PendingFeature {
+        std::string layer;
+        int minZoom;
+        int maxZoom;
+        std::map<std::string, std::string> props;
+        GeometryPtr geometry;
+    };
+
+    TileExport& output_;
+    std::string chartName_;
+    int minZoom_ = 0;
+    std::vector<PendingFeature> pending_;
+
+    bool write() {
+        std::lock_guard<std::mutex> lock(output_.mutex_);
+        if (!output_.dataset_) return false;
+
+        for (auto& pending : pending_) {
+            OGRLayer* layer = output_.getLayer(pending.layer, pending.minZoom, pending.maxZoom);
+            if (!layer) return false;
+
+            // Fields first: adding one afterwards would invalidate the feature
+            std::vector<std::pair<int, const std::string*>> values;
+            for (const auto& [key, value] : pending.props) {
+                int index = output_.getFieldIndex(layer, key);
+                if (index >= 0) values.emplace_back(index, &value);
+            }
+
+            OGRFeature* feature = OGRFeature::CreateFeature(layer->GetLayerDefn());
+            for (const auto& [index, value] : values) {
+                feature->SetField(index, value->c_str());
+            }
+            feature->SetGeometryDirectly(pending.geometry.release());
+            bool ok = layer->CreateFeature(feature) == OGRERR_NONE;
+            OGRFeature::DestroyFeature(feature);
+
+            if (!ok) {
+                std::cerr << "Tile feature write failed for chart " << chartName_ << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+TileExport::TileExport(const TileOptions& options) : options_(options) {
+    GDALAllRegister();
+
+    if (options_.threads > 0) {
+        CPLSetConfigOption("GDAL_NUM_THREADS", std::to_string(options_.threads).c_str());
+    }
+
+    // The MVT driver writes MBTiles itself when the name ends in .mbtiles
+    driverName_ = fs::path(options_.path).extension() == ".pmtiles" ? "PMTiles" : "MVT";
+    GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(driverName_.c_str());
+    if (!driver) {
+        std::cerr << "GDAL driver not available: " << driverName_ << std::endl;
+        return;
+    }
+
+    CPLStringList creationOptions;
+    creationOptions.SetNameValue("MINZOOM", std::to_string(options_.minZoom).c_str());
+    creationOptions.SetNameValue("MAXZOOM", std::to_string(options_.maxZoom).c_str());
+    creationOptions.SetNameValue("NAME", fs::path(options_.path).stem().string().c_str());
+
+    dataset_ = driver->Create(options_.path.c_str(), 0, 0, 0, GDT_Unknown, creationOptions.List());
+    if (!dataset_) {
+        std::cerr << "Failed to create tiles: " << options_.path << std::endl;
+    }
+}
+
+TileExport::~TileExport() {
+    finish();
+}
+
+bool TileExport::isOpen() const {
+    return dataset_ != nullptr;
+}
+
+const std::string& TileExport::getDriverName() const {
+    return driverName_;
+}
+
+OGRLayer* TileExport::getLayer(const std::string& layerName, int minZoom, int maxZoom) {
+    std::string key = layerName + "_" + std::to_string(minZoom) + "_" + std::to_string(maxZoom);
+    auto it = layers_.find(key);
+    if (it != layers_.end()) return it->second;
+
+    OGRSpatialReference wgs84;
+    wgs84.SetWellKnownGeogCS("WGS84");
+    wgs84.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+
+    CPLStringList layerOptions;
+    layerOptions.SetNameValue("NAME", layerName.c_str());
+    layerOptions.SetNameValue("MINZOOM", std::to_string(minZoom).c_str());
+    layerOptions.SetNameValue("MAXZOOM", std::to_string(maxZoom).c_str());
+
+    OGRLayer* layer = dataset_->CreateLayer(key.c_str(), &wgs84, wkbUnknown, layerOptions.List());
+    if (!layer) {
+        std::cerr << "Failed to create tile layer " << key << std::endl;
+        return nullptr;
+    }
+    layers_[key] = layer;
+    return layer;
+}
+
+int TileExport::getFieldIndex(OGRLayer* layer, const std::string& name) {
+    int index = layer->GetLayerDefn()->GetFieldIndex(name.c_str());
+    if (index >= 0) return index;
+
+    OGRFieldDefn field(name.c_str(), OFTString);
+    if (layer->CreateField(&field) != OGRERR_NONE) return -1;
+    return layer->GetLayerDefn()->GetFieldIndex(name.c_str());
+}
+
+std::unique_ptr<ChartSink> TileExport::openSink() {
+    if (!isOpen()) return nullptr;
+    return std::make_unique<TileSink>(*this);
+}
+
+bool TileExport::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dataset_) return false;
+
+    // Tiles are generated and encoded when the dataset is closed
+    GDALClose(dataset_);
+    dataset_ = nullptr;
+    layers_.clear();
+    return true;
+}
+
+} // namespace s57
@@ -0,0 +1,83 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Mapbox Vector Tile pre-generation header
+
+#ifndef S57_POSTGIS_TILES_HPP
+#define S57_POSTGIS_TILES_HPP
+
+#include "types.hpp"
+#include "sink.hpp"
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Forward declarations for GDAL types
+class GDALDataset;
+class OGRLayer;
+
+namespace s57 {
+
+// Tile output options
+struct TileOptions {
+    std::string path;       // .mbtiles, .pmtiles, or a directory of {z}/{x}/{y}.pbf
+    int minZoom = 0;        // Lowest zoom generated
+    int maxZoom = 16;       // Highest zoom generated (clients overzoom past it)
+    int underzoom = 4;      // Zooms below the chart's own zoom it still shows at
+    int threads = 0;        // Tile encoding threads (0 = all CPUs)
+};
+
+// TileExport pre-renders charts into Mapbox Vector Tiles through GDAL's MVT
+// writer, which clips, simplifies and encodes tiles on its own thread pool.
+//
+// Each feature is written for zooms [max(minZ, chart zoom - underzoom), maxZ),
+// where minZ/maxZ come from ZFinder::calculateZRange, so large scale charts
+// stay out of small scale tiles. Every distinct band gets
+// its own OGR layer mapped onto the S-57 layer name in the tiles, so one
+// tile layer can hold features with different zoom ranges. Generalized
+// variants (Feature::lods) are used for the zooms they cover.
+class TileExport {
+public:
+    // Constructor - creates the tile dataset
+    explicit TileExport(const TileOptions& options);
+
+    // Destructor - finishes the tiles if finish() was not called
+    ~TileExport();
+
+    // Prevent copying
+    TileExport(const TileExport&) = delete;
+    TileExport& operator=(const TileExport&) = delete;
+
+    // Check if the output was created successfully
+    bool isOpen() const;
+
+    // Name of the GDAL driver in use
+    const std::string& getDriverName() const;
+
+    // Create a sink for one ingest worker
+    std::unique_ptr<ChartSink> openSink();
+
+    // Generate and write all tiles, then close the dataset
+    bool finish();
+
+private:
+    // Per-worker sink writing into this tile set
+    class TileSink;
+
+    TileOptions options_;
+    std::string driverName_;
+    GDALDataset* dataset_ = nullptr;
+    std::map<std::string, OGRLayer*> layers_;
+    std::mutex mutex_;
+
+    // Get or create the OGR layer for a tile layer and zoom band
+    OGRLayer* getLayer(const std::string& layerName, int minZoom, int maxZoom);
+
+    // Make sure a string field exists on a band layer
+    int getFieldIndex(OGRLayer* layer, const std::string& name);
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_TILES_HPP
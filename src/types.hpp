@@ -12,9 +12,19 @@
 #include <map>
 #include <optional>
 #include <memory>
+#include <cstdint>
 
 namespace s57 {
 
+// Axis-aligned bounding box in WGS84 degrees
+struct BoundingBox {
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+    bool valid = false;         // False for empty geometry
+};
+
 // Chart metadata structure
 struct ChartInfo {
     std::string name;           // Chart name (from DSID.DSNM)
@@ -22,10 +32,21 @@ struct ChartInfo {
     std::string fileName;       // Source file name
     std::string updated;        // Update date (DSID.UADT)
     std::string issued;         // Issue date (DSID.ISDT)
+    std::string edition;        // Edition number (DSID.EDTN)
+    std::string updateNumber;   // Update number (DSID.UPDN)
     int zoom = 0;               // Calculated zoom level
     std::string covrGeoJson;    // Coverage geometry as GeoJSON
     std::string dsidProps;      // DSID properties as JSON
     std::string chartTxt;       // Chart text as JSON (M_COVR properties)
+    BoundingBox bbox;           // Envelope of the coverage
+    int64_t hkey = 0;           // Hilbert key of the bbox center
+};
+
+// Simplified geometry for a zoom band [minZ, maxZ)
+struct GeometryLod {
+    int minZ = 0;
+    int maxZ = 0;
+    std::string geomGeoJson;
 };
 
 // Feature structure
@@ -35,18 +56,93 @@ struct Feature {
     std::string propsJson;      // Properties as JSON
     int minZ = 0;               // Minimum zoom level
     int maxZ = 28;              // Maximum zoom level
+    std::string lnam;                   // Own LNAM (feature identifier)
     std::vector<std::string> lnamRefs;  // LNAM references
+    std::vector<int> lnamRefKinds;      // FFPT_RIND per reference (1 master, 2 slave, 3 peer)
+    std::vector<GeometryLod> lods;      // Generalized geometry below chart zoom
+    std::vector<std::string> parts;     // Subdivided pieces of a large area (GeoJSON)
+    BoundingBox bbox;                   // Envelope of the geometry
+    int64_t hkey = 0;                   // Hilbert key of the bbox center
+};
+
+// A resolved LNAM reference between two features of the same chart
+// from/to are positions in the chart's feature sequence as given to the sink
+struct FeatureLink {
+    size_t from = 0;
+    size_t to = 0;
+    std::string kind;           // master, slave, peer, aggregate or association
+};
+
+// Attributes shared by the soundings of one SOUNDG feature
+struct SoundingAttrs {
+    std::string propsJson;      // Properties as JSON (without METERS)
+    int minZ = 0;               // Minimum zoom level
+    int maxZ = 28;              // Maximum zoom level
+};
+
+// A single sounding
+struct Sounding {
+    double lon = 0.0;
+    double lat = 0.0;
+    double depth = 0.0;         // Meters; NaN if the source point had no Z
+    int attrs = 0;              // Index into SoundingSet::attrs
+};
+
+// All soundings of a chart, stored compactly with --compact-soundings
+struct SoundingSet {
+    std::vector<SoundingAttrs> attrs;
+    std::vector<Sounding> soundings;
+};
+
+// Encode stage options, applied while parsing in the ingest workers
+struct EncodeOptions {
+    bool generalize = false;    // Build simplified geometry per zoom band
+    bool quantize = false;      // Snap coordinates to a grid, compact GeoJSON
+    int precision = -1;         // Decimal places, -1 uses the chart's COMF grid
+    int subdivideVertices = 0;  // Split areas above this many vertices, 0 = off
+    bool compactSoundings = false;  // SOUNDG as a SoundingSet instead of features
+    bool spatialOrder = false;  // Write each chart's features in Hilbert key order
+};
+
+// An S-57 base cell with the update files found for it
+struct CellFile {
+    std::string path;                   // Base cell (.000)
+    std::vector<std::string> updates;   // Update files (.001, .002, ...) in order
+    uintmax_t size = 0;                 // Bytes of the base cell and its updates
 };
 
 // Processing result
 struct ProcessingResult {
     bool success = false;
+    bool skipped = false;       // Already committed (--resume)
     std::string fileName;
     std::string chartName;
     int featureCount = 0;
     std::string errorMessage;
 };
 
+// Result of one host's slice of a sharded ingest (ingest_shards row)
+struct IngestSummary {
+    std::string runId;
+    int shard = 1;
+    int shardCount = 1;
+    std::string host;
+    int files = 0;
+    int succeeded = 0;
+    int failed = 0;
+    int skipped = 0;
+    int64_t features = 0;
+    std::vector<std::string> failures;  // "file: error"
+    std::string finishedAt;
+};
+
+// A cell claimed from the shared ingest queue (ingest_queue row)
+struct QueueItem {
+    int64_t id = 0;
+    std::string path;
+    int attempts = 0;           // Including this claim
+};
+
 // Processing options
 struct ProcessingOptions {
     std::string databaseUrl = "postgresql://localhost/njord";
@@ -56,6 +152,32 @@ struct ProcessingOptions {
     bool listOnly = false;
     bool infoOnly = false;
     bool initSchema = false;
+    EncodeOptions encode;
+    bool staging = false;
+    bool nullSink = false;
+    bool bulkLoad = false;
+    bool unlogged = false;
+    bool quilt = false;
+    bool quiltRebuild = false;
+    std::string dumpDir;
+    bool dumpCompress = false;
+    size_t dumpRowsPerFile = 0;
+    std::string exportPath;
+    std::string tilesPath;
+    int tileMinZoom = 0;
+    int tileMaxZoom = 16;
+    std::string journalPath;
+    bool resume = false;
+    bool watch = false;
+    int watchDebounceMs = 2000;
+    std::string shard;              // "i/N", empty for all charts
+    std::string shardBy = "name";
+    std::string runId = "default";
+    bool shardSummary = false;
+    std::string queueName;          // Shared ingest queue, empty for none
+    int queueLeaseSeconds = 60;
+    bool queueStatus = false;
+    size_t maxMemory = 0;           // Ingest memory budget in bytes, 0 = unlimited
 };
 
 // Excluded layers that should not be processed as features
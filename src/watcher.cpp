@@ -0,0 +1,190 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Chart directory watcher implementation
+
+#include "watcher.hpp"
+#include "exchange_set.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+namespace {
+    // Longest wait between checks of the stop flag
+    constexpr int POLL_INTERVAL_MS = 200;
+
+    bool isCellFile(const fs::path& path) {
+        std::string ext = path.extension().string();
+        return ext.size() == 4 && std::all_of(ext.begin() + 1, ext.end(),
+                                              [](unsigned char c) { return std::isdigit(c); });
+    }
+}
+
+DirectoryWatcher::DirectoryWatcher(std::string root, bool recursive, int debounceMs)
+    : root_(std::move(root))
+    , recursive_(recursive)
+    , debounce_(std::max(0, debounceMs)) {
+#ifdef __linux__
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        std::cerr << "inotify_init1 failed" << std::endl;
+        return;
+    }
+    addWatch(root_);
+    if (dirs_.empty()) {
+        close(fd_);
+        fd_ = -1;
+    }
+#else
+    std::cerr << "--watch needs inotify (Linux)" << std::endl;
+#endif
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+}
+
+bool DirectoryWatcher::isOpen() const {
+    return fd_ >= 0;
+}
+
+void DirectoryWatcher::addWatch(const std::string& dir) {
+#ifdef __linux__
+    int wd = inotify_add_watch(fd_, dir.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+    if (wd < 0) {
+        std::cerr << "Cannot watch " << dir << std::endl;
+        return;
+    }
+    dirs_[wd] = dir;
+
+    if (!recursive_) return;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        std::error_code entryEc;
+        if (it->is_directory(entryEc) && !it->is_symlink(entryEc)) {
+            addWatch(it->path().string());
+        }
+    }
+#else
+    (void)dir;
+#endif
+}
+
+void DirectoryWatcher::touch(const std::string& filePath) {
+    fs::path path(filePath);
+    if (!isCellFile(path)) return;
+
+    // An update is ingested through its base cell, which GDAL applies it
+    // to; in the ENC_ROOT layout that cell is in a sibling directory
+    std::string base = findBaseCell(filePath);
+    if (base.empty()) return;
+    pending_[base] = Clock::now();
+}
+
+void DirectoryWatcher::touchAll() {
+    for (const auto& [wd, dir] : dirs_) {
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            if (it->path().extension() == ".000") {
+                touch(it->path().string());
+            }
+        }
+    }
+}
+
+bool DirectoryWatcher::run(const std::atomic<bool>& stop,
+                           const std::function<void(const std::string&)>& onCell) {
+#ifdef __linux__
+    if (!isOpen()) return false;
+
+    alignas(inotify_event) char buffer[64 * 1024];
+    while (!stop) {
+        pollfd pfd{fd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, POLL_INTERVAL_MS);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "poll on inotify failed" << std::endl;
+            return false;
+        }
+
+        if (ready > 0) {
+            ssize_t length;
+            while ((length = read(fd_, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + length; ) {
+                    auto* event = reinterpret_cast<inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        std::cerr << "Warning: inotify queue overflowed, rescanning" << std::endl;
+                        touchAll();
+                        continue;
+                    }
+                    auto dir = dirs_.find(event->wd);
+                    if (event->mask & IN_IGNORED) {
+                        if (dir != dirs_.end()) dirs_.erase(dir);
+                        continue;
+                    }
+                    if (dir == dirs_.end() || event->len == 0) continue;
+
+                    std::string path = (fs::path(dir->second) / event->name).string();
+                    if (event->mask & IN_ISDIR) {
+                        // Files may land before the watch is added; pick them up too
+                        if (recursive_ && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                            addWatch(path);
+                            std::error_code ec;
+                            for (fs::recursive_directory_iterator it(path, ec);
+                                 !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                                touch(it->path().string());
+                            }
+                        }
+                        continue;
+                    }
+                    // IN_CREATE alone is a file still being written
+                    if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                        touch(path);
+                    }
+                }
+            }
+        }
+
+        // Report cells that have been quiet for the debounce interval
+        auto now = Clock::now();
+        for (auto it = pending_.begin(); it != pending_.end(); ) {
+            if (now - it->second < debounce_) {
+                ++it;
+                continue;
+            }
+            std::error_code ec;
+            if (fs::is_regular_file(it->first, ec)) {
+                onCell(it->first);
+            }
+            it = pending_.erase(it);
+        }
+    }
+    return true;
+#else
+    (void)stop;
+    (void)onCell;
+    return false;
+#endif
+}
+
+} // namespace s57
@@ -0,0 +1,67 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Chart directory watcher header
+
+#ifndef S57_POSTGIS_WATCHER_HPP
+#define S57_POSTGIS_WATCHER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <chrono>
+#include <atomic>
+#include <functional>
+
+namespace s57 {
+
+// DirectoryWatcher follows a chart directory with inotify and reports
+// base cells whose files changed. Events for a cell and its updates
+// (.000 - .999, next to it or in ENC_ROOT sibling directories, matched
+// the way GDAL applies them) are debounced: a cell is reported once none
+// of its files has changed for the debounce interval, so a copy in
+// progress or a base cell arriving with its updates is ingested once. New
+// subdirectories are watched as they appear.
+//
+// Only available on Linux; elsewhere isOpen() is false.
+class DirectoryWatcher {
+public:
+    DirectoryWatcher(std::string root, bool recursive, int debounceMs);
+
+    // Closes the inotify descriptor
+    ~DirectoryWatcher();
+
+    // Prevent copying
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Check if the watch was set up successfully
+    bool isOpen() const;
+
+    // Watch until stop is set, calling onCell with the path of each changed
+    // base cell (.000) after it settles
+    bool run(const std::atomic<bool>& stop, const std::function<void(const std::string&)>& onCell);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string root_;
+    bool recursive_;
+    std::chrono::milliseconds debounce_;
+    int fd_ = -1;
+    std::unordered_map<int, std::string> dirs_;    // Watch descriptor -> directory
+    std::map<std::string, Clock::time_point> pending_;  // Base cell -> last change
+
+    // Watch a directory (and its subdirectories when recursive)
+    void addWatch(const std::string& dir);
+
+    // Note a change to an S-57 file, keyed by its base cell
+    void touch(const std::string& filePath);
+
+    // Mark every cell in the watched directories changed (after lost events)
+    void touchAll();
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_WATCHER_HPP
@@ -0,0 +1,124 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Shared database work queue implementation
+
+#include "work_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace s57 {
+
+namespace {
+    // Wait between claims while the rest of the queue is claimed elsewhere
+    constexpr auto DRAIN_POLL = std::chrono::seconds(2);
+
+    std::string defaultWorkerId() {
+        char host[256] = {};
+        if (gethostname(host, sizeof(host) - 1) != 0) {
+            std::snprintf(host, sizeof(host), "unknown");
+        }
+        return std::string(host) + ":" + std::to_string(getpid());
+    }
+}
+
+WorkQueue::WorkQueue(const std::string& connectionString, std::string name, int leaseSeconds)
+    : db_(connectionString), name_(std::move(name)), workerId_(defaultWorkerId()),
+      leaseSeconds_(std::max(3, leaseSeconds)) {
+    if (db_.isConnected()) {
+        heartbeat_ = std::thread(&WorkQueue::heartbeatLoop, this);
+    }
+}
+
+WorkQueue::~WorkQueue() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopping_ = true;
+    }
+    stopped_.notify_all();
+    if (heartbeat_.joinable()) {
+        heartbeat_.join();
+    }
+}
+
+bool WorkQueue::isOpen() const {
+    return db_.isConnected();
+}
+
+const std::string& WorkQueue::workerId() const {
+    return workerId_;
+}
+
+int WorkQueue::enqueue(const std::vector<CellFile>& cells) {
+    // Other processes have other working directories
+    std::vector<CellFile> absolute = cells;
+    for (auto& cell : absolute) {
+        if (cell.path.rfind("/vsi", 0) != 0) {
+            cell.path = fs::absolute(cell.path).lexically_normal().string();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return db_.enqueueCells(name_, absolute);
+}
+
+std::optional<QueueItem> WorkQueue::claim() {
+    while (true) {
+        int open = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (failed_) return std::nullopt;
+            auto item = db_.claimQueueItem(name_, workerId_, leaseSeconds_, QUEUE_MAX_ATTEMPTS, &open);
+            if (item) {
+                claims_.insert(item->id);
+                return item;
+            }
+            if (open < 0) {
+                failed_ = true;
+                return std::nullopt;
+            }
+        }
+        if (open == 0) return std::nullopt;
+
+        std::unique_lock<std::mutex> lock(stopMutex_);
+        if (stopped_.wait_for(lock, DRAIN_POLL, [this]() { return stopping_; })) {
+            return std::nullopt;
+        }
+    }
+}
+
+void WorkQueue::finish(const QueueItem& item, const ProcessingResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    claims_.erase(item.id);
+    if (!db_.finishQueueItem(item, workerId_, result)) {
+        std::cerr << "Warning: claim on " << item.path
+                  << " was lost; the cell may be ingested again" << std::endl;
+    }
+}
+
+bool WorkQueue::failed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+void WorkQueue::heartbeatLoop() {
+    auto interval = std::chrono::seconds(leaseSeconds_ / 3);
+    std::unique_lock<std::mutex> stopLock(stopMutex_);
+    while (!stopped_.wait_for(stopLock, interval, [this]() { return stopping_; })) {
+        stopLock.unlock();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            db_.heartbeatQueue(workerId_, std::vector<int64_t>(claims_.begin(), claims_.end()));
+        }
+        stopLock.lock();
+    }
+}
+
+} // namespace s57
@@ -0,0 +1,90 @@
+// Copyright 2024 S57-PostGIS Authors
+// SPDX-License-Identifier: Apache-2.0
+//
+// Shared database work queue header
+
+#ifndef S57_POSTGIS_WORK_QUEUE_HPP
+#define S57_POSTGIS_WORK_QUEUE_HPP
+
+#include "types.hpp"
+#include "database.hpp"
+#include <string>
+#include <vector>
+#include <optional>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace s57 {
+
+// Claims after which a cell whose workers keep dying is given up on
+constexpr int QUEUE_MAX_ATTEMPTS = 3;
+
+// WorkQueue lets several ingest processes, on one host or many, share the
+// cells of an ingest_queue: each claims the next cell when it is ready for
+// one, so fast hosts take more cells than slow ones. A background thread
+// refreshes the heartbeat of each cell this process holds every third of
+// the lease, from claim until finish(); the cells of a process that dies,
+// or whose heartbeat can't reach the database, are taken back by the next
+// claim anywhere once the lease runs out and handed out again. A worker
+// thread stuck inside a chart keeps its claim for as long as the process
+// lives.
+//
+// One connection is shared by all workers of the process; claims are
+// short compared to processing a chart.
+class WorkQueue {
+public:
+    WorkQueue(const std::string& connectionString, std::string name, int leaseSeconds);
+
+    // Stops the heartbeat thread
+    ~WorkQueue();
+
+    // Prevent copying
+    WorkQueue(const WorkQueue&) = delete;
+    WorkQueue& operator=(const WorkQueue&) = delete;
+
+    // Check if the database connection is open
+    bool isOpen() const;
+
+    // Worker name written with claims (host:pid)
+    const std::string& workerId() const;
+
+    // Add cells the queue doesn't have yet; returns the number added, -1 on
+    // error. Every process can queue the same input; paths must then be the
+    // same on all hosts (a shared mount).
+    int enqueue(const std::vector<CellFile>& cells);
+
+    // Claim the next cell. While other processes still hold claims that may
+    // come back, waits for them; nullopt once the queue is drained or can't
+    // be read (see failed()).
+    std::optional<QueueItem> claim();
+
+    // Record the result of a claimed cell
+    void finish(const QueueItem& item, const ProcessingResult& result);
+
+    // Check if claim() stopped because the queue couldn't be read, rather
+    // than because it was drained
+    bool failed() const;
+
+private:
+    Database db_;
+    std::string name_;
+    std::string workerId_;
+    int leaseSeconds_;
+
+    mutable std::mutex mutex_;          // Guards db_, claims_ and failed_
+    std::set<int64_t> claims_;          // Ids held until finish()
+    bool failed_ = false;
+    std::thread heartbeat_;
+    std::mutex stopMutex_;
+    std::condition_variable stopped_;
+    bool stopping_ = false;
+
+    // Refresh heartbeats until the queue is destroyed
+    void heartbeatLoop();
+};
+
+} // namespace s57
+
+#endif // S57_POSTGIS_WORK_QUEUE_HPP